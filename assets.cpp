@@ -2,19 +2,42 @@
 // File
 //
 
+// files are looked up in the mounted pack first (see mount_pack())
+global Pack asset_pack;
+global File asset_pack_file;
+
+// padding bytes after the file are set to 0. size does not include them.
 internal File
-load_file(const char *filepath) {
+load_file_padded(const char *filepath, u32 padding) {
     File result = {};
     
+    const Pack_Entry *entry = pack_find(&asset_pack, filepath);
+    if (entry) {
+        result.filepath = filepath;
+        result.memory = platform_malloc(entry->size + padding);
+        if (!pack_read_entry(&asset_pack, entry, result.memory)) {
+            logprint("load_file", "Broken pack entry %s\n", filepath);
+            platform_free(result.memory);
+            result.memory = 0;
+            return result;
+        }
+        result.size = entry->size;
+        if (padding)
+            platform_memory_set((u8*)result.memory + result.size, 0, padding);
+        return result;
+    }
+
     FILE *in = fopen(filepath, "rb");
     if(in) {
         fseek(in, 0, SEEK_END);
         result.size = ftell(in);
         fseek(in, 0, SEEK_SET);
         
-        result.memory = platform_malloc(result.size);
+        result.memory = platform_malloc(result.size + padding);
         fread(result.memory, result.size, 1, in);
         fclose(in);
+        if (padding)
+            platform_memory_set((u8*)result.memory + result.size, 0, padding);
     } else { 
     	logprint("load_file", "Cannot open file %s\n", filepath);
     }
@@ -24,40 +47,217 @@ load_file(const char *filepath) {
     return result;
 }
 
+internal File
+load_file(const char *filepath) {
+    return load_file_padded(filepath, 0);
+}
+
 // returns the file with a 0 at the end of the memory.
 // useful if you want to read the file like a string immediately.
 internal File
 load_file_terminated(const char *filename) {
+    File result = load_file_padded(filename, 1);
+    if (result.memory != 0)
+        result.size++; // the 0 counts
+    return result;
+}
+
+// the file is not copied into memory, pages are read when they are touched. falls back
+// to load_file() if it can not be mapped. either way give it back with free_file().
+// files stored uncompressed in the pack are handed out in place.
+internal File
+map_file(const char *filepath) {
     File result = {};
-    File file = load_file(filename);
 
-    //result = file;
-    result.size = file.size + 1;
-    result.filepath = filename;
-    result.memory = platform_malloc(result.size);
-    platform_memory_copy(result.memory, file.memory, file.size);
+    const Pack_Entry *entry = pack_find(&asset_pack, filepath);
+    if (entry) {
+        if (entry->compression != PACK_COMPRESSION_NONE)
+            return load_file(filepath);
+        result.filepath = filepath;
+        result.memory = (void*)pack_entry_memory(&asset_pack, entry);
+        result.size = entry->size;
+        result.mapped = true;
+        result.in_pack = true;
+        return result;
+    }
 
-    char *r = (char*)result.memory;
-    r[file.size] = 0; // last byte in result.memory
-    
+    result.memory = platform_map_file(filepath, &result.size);
+    if (result.memory == 0)
+        return load_file(filepath);
+
+    result.filepath = filepath;
+    result.mapped = true;
     return result;
 }
 
+internal void
+free_file(File *file) {
+    if (file->memory != 0 && !file->in_pack) {
+        if (file->mapped)
+            platform_unmap_file(file->memory, file->size);
+        else
+            platform_free(file->memory);
+    }
+    file->memory = 0;
+    file->size = 0;
+    file->mapped = false;
+    file->in_pack = false;
+}
+
+// maps the pack made by packer.cpp. until unmount_pack() the files in it are loaded
+// from there instead of from disk. returns false if there is no usable pack at filepath.
+internal bool8
+mount_pack(const char *filepath) {
+    File file = {};
+    file.memory = platform_map_file(filepath, &file.size);
+    if (file.memory == 0)
+        return false; // no pack, files stay loose
+
+    file.filepath = filepath;
+    file.mapped = true;
+    Pack pack = {};
+    if (!pack_open(&pack, file.memory, file.size)) {
+        logprint("mount_pack()", "%s is not a valid pack\n", filepath);
+        free_file(&file);
+        return false;
+    }
+
+    asset_pack = pack;
+    asset_pack_file = file;
+    return true;
+}
+
+// no file handed out from the pack can be used after this
+internal void
+unmount_pack() {
+    asset_pack = {};
+    free_file(&asset_pack_file);
+}
+
+// returns false if the file could not be written
+internal bool8
+save_file(const char *filepath, const void *memory, u32 size) {
+    FILE *out = fopen(filepath, "wb");
+    if (!out) {
+        logprint("save_file", "Cannot open file %s\n", filepath);
+        return false;
+    }
+
+    u32 written = (u32)fwrite(memory, 1, size, out);
+    fclose(out);
+
+    if (written != size) {
+        logprint("save_file", "Failed to write all of %s\n", filepath);
+        return false;
+    }
+    return true;
+}
+
+//
+// File Stream
+//
+
+// long is 32 bits on windows, these take 64 bit offsets everywhere
+#ifdef WINDOWS
+#define file_seek_64 _fseeki64
+#define file_tell_64 _ftelli64
+#else
+#define file_seek_64 fseeko
+#define file_tell_64 ftello
+#endif // WINDOWS
+
+internal bool8
+open_file_stream(File_Stream *stream, const char *filepath, u32 chunk_capacity) {
+    *stream = {};
+
+    // entries of the mounted pack are read out of the pack
+    if (pack_find(&asset_pack, filepath)) {
+        stream->file = map_file(filepath);
+        if (stream->file.memory == 0)
+            return false;
+        stream->size = stream->file.size;
+    } else {
+        stream->handle = fopen(filepath, "rb");
+        if (!stream->handle) {
+            logprint("open_file_stream()", "Cannot open file %s\n", filepath);
+            return false;
+        }
+
+        file_seek_64(stream->handle, 0, SEEK_END);
+        stream->size = (u64)file_tell_64(stream->handle);
+        file_seek_64(stream->handle, 0, SEEK_SET);
+    }
+
+    stream->filepath = filepath;
+    stream->chunk_capacity = chunk_capacity;
+    stream->chunk = (u8*)platform_malloc(chunk_capacity);
+    return true;
+}
+
+// reads the next chunk_capacity bytes (less at the end) into chunk.
+// returns false if there was nothing left to read.
+internal bool8
+file_stream_read(File_Stream *stream) {
+    stream->chunk_size = 0;
+    if (stream->position >= stream->size)
+        return false;
+
+    u64 remaining = stream->size - stream->position;
+    u32 size = (remaining < stream->chunk_capacity) ? (u32)remaining : stream->chunk_capacity;
+    if (stream->handle) {
+        stream->chunk_size = (u32)fread(stream->chunk, 1, size, stream->handle);
+    } else {
+        platform_memory_copy(stream->chunk, (u8*)stream->file.memory + stream->position, size);
+        stream->chunk_size = size;
+    }
+    stream->position += stream->chunk_size;
+    if (stream->chunk_size != size)
+        logprint("file_stream_read()", "Failed to read all of %s\n", stream->filepath);
+    return stream->chunk_size > 0;
+}
+
+// the next read starts at position
+internal void
+file_stream_seek(File_Stream *stream, u64 position) {
+    if (position > stream->size)
+        position = stream->size;
+    if (stream->handle)
+        file_seek_64(stream->handle, (s64)position, SEEK_SET);
+    stream->position = position;
+}
+
+internal void
+close_file_stream(File_Stream *stream) {
+    if (stream->handle)
+        fclose(stream->handle);
+    free_file(&stream->file);
+    if (stream->chunk)
+        platform_free(stream->chunk);
+    *stream = {};
+}
+
 //
 // Bitmap
 //
 
 internal Bitmap
 load_bitmap(const char *filename, bool8 flip_on_load) {
-    if (flip_on_load) stbi_set_flip_vertically_on_load(true);
-    else              stbi_set_flip_vertically_on_load(false);
+    // the flag is per thread so bitmaps can be decoded on several threads at once
+    stbi_set_flip_vertically_on_load_thread(flip_on_load ? 1 : 0);
     Bitmap bitmap = {};
     bitmap.channels = 4;
+
+    // goes through map_file() so the bitmap can come from the mounted pack
+    File file = map_file(filename);
+    if (file.memory == 0)
+        return bitmap;
+
     // 4 arg always get filled in with the original amount of channels the image had.
     // Currently forcing it to have 4 channels.
-    bitmap.memory = stbi_load(filename, &bitmap.width, &bitmap.height, 0, bitmap.channels);
+    bitmap.memory = stbi_load_from_memory((stbi_uc*)file.memory, (int)file.size, &bitmap.width, &bitmap.height, 0, bitmap.channels);
+    free_file(&file);
     
-    if (bitmap.memory == 0) logprint("load_bitmap()" "could not load bitmap %s\n", filename);
+    if (bitmap.memory == 0) logprint("load_bitmap()", "could not load bitmap %s\n", filename);
     bitmap.pitch = bitmap.width * bitmap.channels;
     return bitmap;
 }
@@ -69,7 +269,295 @@ load_bitmap(const char *filename) {
 
 internal void
 free_bitmap(Bitmap bitmap) {
-    stbi_image_free(bitmap.memory);
+    if (bitmap.file.memory != 0)
+        free_file(&bitmap.file); // memory points into it
+    else
+        stbi_image_free(bitmap.memory);
+}
+
+//
+// Cooked Texture
+//
+
+// hashes the source a chunk at a time, so checking an up to date cooked file never
+// needs the whole source in memory. returns false if it could not be read.
+internal bool8
+cooked_texture_hash(const char *source_filepath, bool8 flip_on_load, u32 formats, u64 *result) {
+	File_Stream stream;
+	if (!open_file_stream(&stream, source_filepath, COOKED_TEXTURE_HASH_CHUNK))
+		return false;
+
+	u64 hash = FNV_64_OFFSET_BASIS;
+	while (file_stream_read(&stream))
+		hash = fnv1a_64(stream.chunk, stream.chunk_size, hash);
+	bool8 complete = stream.position == stream.size;
+	close_file_stream(&stream);
+	if (!complete)
+		return false;
+
+	// the formats are part of it so a gpu that can sample other formats cooks again
+	u32 settings[2] = { (u32)flip_on_load, formats };
+	*result = fnv1a_64(settings, sizeof(settings), hash);
+	return true;
+}
+
+// BC1 if there is no alpha, otherwise BC7 or BC3. pixels if the gpu can not sample any of them.
+internal u32
+cooked_texture_format(Bitmap *bitmap, s32 source_channels, u32 formats) {
+	bool8 alpha = false;
+	if (source_channels == 2 || source_channels == 4) {
+		u32 pixels_count = (u32)(bitmap->width * bitmap->height);
+		for (u32 i = 0; i < pixels_count && !alpha; i++)
+			alpha = bitmap->memory[i * 4 + 3] != 0xFF;
+	}
+
+	if (!alpha && (formats & TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_BC1_SRGB)))
+		return TEXTURE_FORMAT_BC1_SRGB;
+	if (formats & TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_BC7_SRGB))
+		return TEXTURE_FORMAT_BC7_SRGB;
+	if (formats & TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_BC3_SRGB))
+		return TEXTURE_FORMAT_BC3_SRGB;
+	return TEXTURE_FORMAT_PIXELS;
+}
+
+// returns false if there is no cooked file or it was made from a different source.
+// the bitmap memory points into the mapped file, free_bitmap() unmaps it.
+internal bool8
+load_cooked_texture(const char *filepath, u64 source_hash, Bitmap *bitmap) {
+	// not map_file(): a missing file is expected here and should not be logged
+	File file = {};
+	file.memory = platform_map_file(filepath, &file.size);
+	if (file.memory == 0)
+		return false;
+	file.filepath = filepath;
+	file.mapped = true;
+
+	Cooked_Texture_Header header = {};
+	if (file.size >= sizeof(header))
+		platform_memory_copy(&header, file.memory, sizeof(header));
+	bool8 valid = file.size >= sizeof(header) &&
+	              header.magic == COOKED_TEXTURE_MAGIC &&
+	              header.version == COOKED_TEXTURE_VERSION &&
+	              header.source_hash == source_hash &&
+	              header.format < TEXTURE_FORMATS_COUNT &&
+	              header.mip_levels >= 1 && header.mip_levels <= COOKED_TEXTURE_MAX_LEVELS;
+	if (valid) {
+		Cooked_Texture_Level *last = &header.levels[header.mip_levels - 1];
+		valid = (u64)last->offset + last->size <= file.size - sizeof(header);
+		if (!valid)
+			logprint("load_cooked_texture()", "%s is cut off\n", filepath);
+	}
+	if (!valid) {
+		free_file(&file);
+		return false;
+	}
+
+	bitmap->file = file;
+	bitmap->memory = (u8*)file.memory + sizeof(header);
+	bitmap->width = (s32)header.width;
+	bitmap->height = (s32)header.height;
+	bitmap->channels = 4;
+	bitmap->pitch = bitmap->width * bitmap->channels;
+	bitmap->mip_levels = header.mip_levels;
+	bitmap->format = header.format;
+	return true;
+}
+
+// replaces the level 0 only memory of a decoded 4 channel bitmap with its whole mip chain
+// and writes the cooked file. levels are halved down to 1x1 like on the gpu.
+internal bool8
+cook_bitmap(Bitmap *bitmap, s32 source_channels, u64 source_hash, u32 formats, const char *filepath) {
+	Cooked_Texture_Header header = {};
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.source_hash = source_hash;
+	header.format = cooked_texture_format(bitmap, source_channels, formats);
+	header.width = (u32)bitmap->width;
+	header.height = (u32)bitmap->height;
+
+	u32 width = header.width;
+	u32 height = header.height;
+	u32 size = 0;
+	while (header.mip_levels < COOKED_TEXTURE_MAX_LEVELS) {
+		Cooked_Texture_Level *level = &header.levels[header.mip_levels++];
+		level->offset = size;
+		level->size = width * height * 4;
+		level->width = width;
+		level->height = height;
+		size += level->size;
+
+		if (width == 1 && height == 1)
+			break;
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+
+	u8 *memory = (u8*)STBI_MALLOC(size);
+	platform_memory_copy(memory, bitmap->memory, header.levels[0].size);
+	for (u32 i = 1; i < header.mip_levels; i++) {
+		Cooked_Texture_Level *source = &header.levels[i - 1];
+		Cooked_Texture_Level *level = &header.levels[i];
+		stbir_resize_uint8_srgb(memory + source->offset, source->width, source->height, source->width * 4,
+		                        memory + level->offset, level->width, level->height, level->width * 4, 4, 3, 0);
+	}
+
+	if (header.format != TEXTURE_FORMAT_PIXELS) {
+		Block_Encode *encode = bc7_encode_block;
+		if      (header.format == TEXTURE_FORMAT_BC1_SRGB) encode = bc1_encode_block;
+		else if (header.format == TEXTURE_FORMAT_BC3_SRGB) encode = bc3_encode_block;
+		u32 block_size = texture_level_size(header.format, 4, 4, 4);
+
+		u32 compressed_size = 0;
+		for (u32 i = 0; i < header.mip_levels; i++)
+			compressed_size += texture_level_size(header.format, 4, header.levels[i].width, header.levels[i].height);
+
+		u8 *compressed = (u8*)STBI_MALLOC(compressed_size);
+		u32 offset = 0;
+		for (u32 i = 0; i < header.mip_levels; i++) {
+			Cooked_Texture_Level *level = &header.levels[i];
+			block_compress(memory + level->offset, level->width, level->height, encode, block_size, compressed + offset);
+			level->offset = offset;
+			level->size = texture_level_size(header.format, 4, level->width, level->height);
+			offset += level->size;
+		}
+
+		STBI_FREE(memory);
+		memory = compressed;
+		size = compressed_size;
+	}
+
+	stbi_image_free(bitmap->memory);
+	bitmap->memory = memory;
+	bitmap->mip_levels = header.mip_levels;
+	bitmap->format = header.format;
+
+	// two loads of the same source at once can both write here. the second write has the same contents.
+	FILE *out = fopen(filepath, "wb");
+	if (!out) {
+		logprint("cook_bitmap()", "Cannot open file %s\n", filepath);
+		return false;
+	}
+	bool8 written = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(memory, size, 1, out) == 1;
+	fclose(out);
+	if (!written) {
+		logprint("cook_bitmap()", "Failed to write all of %s\n", filepath);
+		remove(filepath); // a cut off file would fail the size check every time
+	}
+	return written;
+}
+
+// loads <filepath>.cooked if it was made from this version of filepath. otherwise decodes filepath
+// and cooks it for the next time. the bitmap always has 4 channels and its whole mip chain.
+// formats are the Texture_Format bits it can be cooked to.
+internal Bitmap
+load_bitmap_cached(const char *filepath, bool8 flip_on_load, u32 formats = TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_PIXELS)) {
+	Bitmap bitmap = {};
+
+	u64 hash;
+	if (!cooked_texture_hash(filepath, flip_on_load, formats, &hash))
+		return bitmap;
+
+	char cooked_filepath[COOKED_TEXTURE_MAX_PATH];
+	u32 length = 0;
+	char_array_appendf(cooked_filepath, COOKED_TEXTURE_MAX_PATH, &length, "%s.cooked", filepath);
+
+	if (length >= COOKED_TEXTURE_MAX_PATH || !load_cooked_texture(cooked_filepath, hash, &bitmap)) {
+		// only decoded, so it does not need a copy
+		File source = map_file(filepath);
+		if (source.memory == 0)
+			return bitmap;
+
+		stbi_set_flip_vertically_on_load_thread(flip_on_load ? 1 : 0);
+		bitmap.channels = 4;
+		s32 source_channels = 0;
+		bitmap.memory = stbi_load_from_memory((stbi_uc*)source.memory, (int)source.size, &bitmap.width, &bitmap.height, &source_channels, bitmap.channels);
+		bitmap.pitch = bitmap.width * bitmap.channels;
+		free_file(&source);
+
+		if (bitmap.memory == 0)
+			logprint("load_bitmap_cached()", "could not load bitmap %s\n", filepath);
+		else if (length < COOKED_TEXTURE_MAX_PATH)
+			cook_bitmap(&bitmap, source_channels, hash, formats, cooked_filepath);
+	}
+
+	return bitmap;
+}
+
+//
+// Bitmap Loader
+//
+
+internal void
+bitmap_loader_init(Bitmap_Loader *loader, Work_Queue *work_queue) {
+	*loader = {};
+	loader->work_queue = work_queue;
+	loader->texture_formats = TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_PIXELS);
+	for (u32 i = 0; i < BITMAP_LOADER_MAX_LOADS; i++) {
+		loader->loads[i].loader = loader;
+		loader->loads[i].slot = i;
+		loader->free_slots[i] = BITMAP_LOADER_MAX_LOADS - 1 - i;
+	}
+	loader->free_slots_count = BITMAP_LOADER_MAX_LOADS;
+}
+
+// runs on a worker thread
+internal void
+bitmap_loader_decode(u32 thread_index, void *data) {
+	Bitmap_Load *load = (Bitmap_Load*)data;
+	Bitmap_Loader *loader = load->loader;
+	{
+		TRACE_ZONE("decode_bitmap");
+		if (loader->use_cache)
+			load->bitmap = load_bitmap_cached(load->filepath, load->flip_on_load, loader->texture_formats);
+		else
+			load->bitmap = load_bitmap(load->filepath, load->flip_on_load);
+	}
+
+	// there are never more than BITMAP_LOADER_MAX_LOADS unreceived loads,
+	// so the position was received and cleared before it comes around again
+	u32 position = (u32)SDL_AtomicAdd(&loader->completed_write, 1) % BITMAP_LOADER_MAX_LOADS;
+	SDL_MemoryBarrierRelease(); // bitmap has to be written before it is visible
+	SDL_AtomicSet(&loader->completed[position], (s32)load->slot + 1);
+}
+
+// returns false if BITMAP_LOADER_MAX_LOADS loads are in flight. receive some and try again.
+internal bool8
+bitmap_loader_add(Bitmap_Loader *loader, const char *filepath, bool8 flip_on_load, void *user_data) {
+	if (loader->free_slots_count == 0)
+		return false;
+
+	u32 slot = loader->free_slots[--loader->free_slots_count];
+	Bitmap_Load *load = &loader->loads[slot];
+	load->filepath = filepath;
+	load->flip_on_load = flip_on_load;
+	load->user_data = user_data;
+	load->bitmap = {};
+
+	work_queue_add(loader->work_queue, bitmap_loader_decode, load);
+	return true;
+}
+
+// copies the next decoded load into result. returns false if none is done yet.
+// the receiver owns result->bitmap.memory and frees it with free_bitmap().
+internal bool8
+bitmap_loader_receive(Bitmap_Loader *loader, Bitmap_Load *result) {
+	u32 position = loader->completed_read % BITMAP_LOADER_MAX_LOADS;
+	s32 value = SDL_AtomicGet(&loader->completed[position]);
+	if (value == 0)
+		return false;
+	SDL_MemoryBarrierAcquire();
+
+	u32 slot = (u32)(value - 1);
+	*result = loader->loads[slot];
+	SDL_AtomicSet(&loader->completed[position], 0);
+	loader->completed_read++;
+	loader->free_slots[loader->free_slots_count++] = slot;
+	return true;
+}
+
+inline u32
+bitmap_loader_in_flight(Bitmap_Loader *loader) {
+	return BITMAP_LOADER_MAX_LOADS - loader->free_slots_count;
 }
 
 //
@@ -77,9 +565,12 @@ free_bitmap(Bitmap bitmap) {
 //
 
 void free_mesh(Mesh *mesh) {
+    render_free_mesh(mesh); // release gpu memory before the gpu_info that points to it
+
     platform_free(mesh->vertices);
     platform_free(mesh->indices);
     platform_free(mesh->gpu_info);
+    mesh->gpu_info = 0;
 }
 
 //
@@ -98,8 +589,7 @@ void load_shader(Shader *shader)
 
     printf("loaded shader: ");
     for (u32 i = 0; i < SHADER_TYPE_AMOUNT; i++) {
-        if (shader->files[i].memory != 0) platform_free(&shader->files[i].memory);
-        shader->files[i].memory = 0;
+        free_file(&shader->files[i]);
 
         if (shader->files[i].filepath != 0) {
             shader->files[i] = load_file_terminated(shader->files[i].filepath);
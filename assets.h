@@ -27,9 +27,29 @@ struct File {
 	const char *filepath;
 	u32 size;
 	void *memory;
+	bool8 mapped; // memory is a read only view of the file
+	bool8 in_pack; // memory is part of the mounted pack, nothing to free
 };
 
 File load_file(const char *filepath);
+File map_file(const char *filepath);
+void free_file(File *file);
+bool8 save_file(const char *filepath, const void *memory, u32 size);
+
+// reads a file one chunk at a time into the same buffer, so only chunk_capacity
+// bytes of it are in memory at once. sizes and offsets are 64 bit, the file can be
+// bigger than what fits in memory.
+struct File_Stream {
+	FILE *handle;
+	File file;          // used instead of handle if the file is in the mounted pack
+	const char *filepath;
+	u64 size;           // of the whole file
+	u64 position;       // where the next chunk starts
+
+	u8 *chunk;
+	u32 chunk_capacity;
+	u32 chunk_size;     // bytes read by the last file_stream_read()
+};
 
 struct Bitmap {
 	u8 *memory;
@@ -44,10 +64,121 @@ struct Bitmap {
 
 	s32 pitch;
 	s32 channels;
+	u32 mip_levels; // memory holds this many levels one after the other. 0 or 1 = only level 0
+	u32 format;     // Texture_Format
+	
+	File file;        // memory points into it if it is mapped (cooked textures)
 	
 	void *gpu_handle; // information about bitmap on gpu
 };
 
+// how a bitmap is sampled. passed to render_init_bitmap()
+enum Texture_Parameters
+{
+    TEXTURE_PARAMETERS_DEFAULT,
+    TEXTURE_PARAMETERS_CHAR,
+};
+
+// how the memory of a bitmap is laid out
+enum Texture_Format
+{
+    TEXTURE_FORMAT_PIXELS,   // 8 bits per channel, channels decides the rest
+    TEXTURE_FORMAT_BC1_SRGB, // 8 bytes per 4x4 block, no alpha
+    TEXTURE_FORMAT_BC3_SRGB, // 16 bytes per 4x4 block
+    TEXTURE_FORMAT_BC7_SRGB, // 16 bytes per 4x4 block
+
+    TEXTURE_FORMATS_COUNT
+};
+
+#define TEXTURE_FORMAT_BIT(format) (1u << (format))
+
+// bytes of one level. block compressed levels pad the edge blocks.
+inline u32
+texture_level_size(u32 format, s32 channels, u32 width, u32 height) {
+	u32 blocks = ((width + 3) / 4) * ((height + 3) / 4);
+	switch(format) {
+		case TEXTURE_FORMAT_BC1_SRGB: return blocks * 8;
+		case TEXTURE_FORMAT_BC3_SRGB:
+		case TEXTURE_FORMAT_BC7_SRGB: return blocks * 16;
+	}
+	return width * height * channels;
+}
+
+//
+// Cooked Texture
+//
+
+// a decoded bitmap with its mip chain, written next to the source as <source>.cooked
+// the first time it is loaded. the header is followed by the levels one after the other
+// in the layout they get uploaded in. loading it again maps the file and the levels are
+// copied from there into the staging memory.
+// pixels are 4 channel srgb. the block compressed format is picked from the formats
+// the gpu can sample (see cooked_texture_format()).
+
+#define COOKED_TEXTURE_MAGIC      0x58544B43 // "CKTX"
+#define COOKED_TEXTURE_VERSION    2
+#define COOKED_TEXTURE_MAX_LEVELS 16
+#define COOKED_TEXTURE_MAX_PATH   256
+#define COOKED_TEXTURE_HASH_CHUNK (64 * 1024) // the source is hashed this much at a time
+
+struct Cooked_Texture_Level {
+	u32 offset; // from the first level
+	u32 size;
+	u32 width;
+	u32 height;
+};
+
+struct Cooked_Texture_Header {
+	u32 magic;
+	u32 version;
+	u64 source_hash; // of the source file and the settings it was cooked with
+	u32 format;      // Texture_Format
+	u32 width;
+	u32 height;
+	u32 mip_levels;
+	Cooked_Texture_Level levels[COOKED_TEXTURE_MAX_LEVELS];
+};
+
+//
+// Bitmap Loader
+//
+
+// decodes bitmaps on the threads of a work queue. one thread (the render thread)
+// adds loads and receives the decoded bitmaps, so it can upload them right away.
+// the workers hand finished loads back through a lock-free completion queue.
+
+#define BITMAP_LOADER_MAX_LOADS 255 // in flight at once. less than WORK_QUEUE_ENTRIES so the queue never runs a decode inline
+
+struct Work_Queue;
+struct Bitmap_Loader;
+
+struct Bitmap_Load {
+	Bitmap_Loader *loader;
+	u32 slot;
+
+	const char *filepath; // has to stay valid until the load is received
+	bool8 flip_on_load;
+	void *user_data;
+
+	Bitmap bitmap;        // memory is 0 if decoding failed
+};
+
+struct Bitmap_Loader {
+	Work_Queue *work_queue; // should only be used by the loader
+	bool8 use_cache;        // config: set before adding. loads go through load_bitmap_cached()
+	u32 texture_formats;    // config: set before adding. Texture_Format bits the cooked files can use
+	Bitmap_Load loads[BITMAP_LOADER_MAX_LOADS];
+
+	// only the adding thread touches these
+	u32 free_slots[BITMAP_LOADER_MAX_LOADS];
+	u32 free_slots_count;
+	u32 completed_read;
+
+	// completion queue: workers reserve a position with completed_write and store slot + 1 there
+	SDL_atomic_t completed[BITMAP_LOADER_MAX_LOADS]; // 0 = not written yet
+	SDL_atomic_t completed_write;
+};
+
 struct Uniform_Buffer_Object {
 	void *handle; // OpenGL = u32; Vulkan = void*
 	u32 size;
@@ -1,6 +1,16 @@
 #version 450
 
-layout(binding = 1) uniform sampler2D texSampler;
+#if defined(BINDLESS)
+#extension GL_EXT_nonuniform_qualifier : require
+layout(set = 1, binding = 0) uniform sampler2D textures[]; // every texture of the texture table
+layout(push_constant) uniform Draw_Constants {
+    uint texture_index;
+} draw;
+#elif defined(VULKAN)
+layout(set = 1, binding = 0) uniform sampler2D texSampler; // set of the bound texture
+#else
+layout(binding = 0) uniform sampler2D texSampler;
+#endif
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
@@ -8,6 +18,10 @@ layout(location = 1) in vec2 fragTexCoord;
 layout(location = 0) out vec4 outColor;
 
 void main() {
+#ifdef BINDLESS
+    outColor = texture(textures[draw.texture_index], fragTexCoord);
+#else
     outColor = texture(texSampler, fragTexCoord);
+#endif
     //outColor = vec4(fragColor, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+//
+// Benchmark
+//
+
+// records the time of every frame of a fixed length run and writes the
+// distribution as json at the end. all times are in milliseconds.
+
+#define BENCHMARK_HISTOGRAM_BUCKETS 64   // the last bucket holds everything above
+#define BENCHMARK_BUCKET_WIDTH_MS   0.5f
+
+struct Benchmark_Stats {
+	u32 samples_count;
+	float32 min;
+	float32 median;
+	float32 p95;
+	float32 p99;
+	float32 max;
+	float32 mean;
+	u32 histogram[BENCHMARK_HISTOGRAM_BUCKETS];
+};
+
+struct Benchmark {
+	u32 frames_count;                      // frames to run
+	const char *output_filepath = "benchmark.json";
+
+	float32 *cpu_ms;                       // preallocated for frames_count so recording never allocates
+	float32 *gpu_ms;                       // < 0 if there was no gpu time for the frame
+	u32 recorded_count;
+};
+
+internal void
+benchmark_init(Benchmark *bench, u32 frames_count) {
+	bench->frames_count = frames_count;
+	bench->cpu_ms = ARRAY_MALLOC(float32, frames_count);
+	bench->gpu_ms = ARRAY_MALLOC(float32, frames_count);
+	bench->recorded_count = 0;
+}
+
+internal void
+benchmark_destroy(Benchmark *bench) {
+	platform_free(bench->cpu_ms);
+	platform_free(bench->gpu_ms);
+	bench->cpu_ms = 0;
+	bench->gpu_ms = 0;
+}
+
+inline bool8
+benchmark_done(Benchmark *bench) {
+	return bench->recorded_count >= bench->frames_count;
+}
+
+inline void
+benchmark_record(Benchmark *bench, float32 cpu_ms, float32 gpu_ms) {
+	if (benchmark_done(bench))
+		return;
+
+	bench->cpu_ms[bench->recorded_count] = cpu_ms;
+	bench->gpu_ms[bench->recorded_count] = gpu_ms;
+	bench->recorded_count++;
+}
+
+internal int
+benchmark_compare_float32(const void *a, const void *b) {
+	float32 fa = *(const float32*)a;
+	float32 fb = *(const float32*)b;
+	return (fa > fb) - (fa < fb);
+}
+
+// nearest rank on sorted samples
+inline float32
+benchmark_percentile(const float32 *sorted, u32 count, float32 percent) {
+	u32 rank = (u32)ceilf(percent * (float32)count);
+	if (rank < 1)     rank = 1;
+	if (rank > count) rank = count;
+	return sorted[rank - 1];
+}
+
+// skips negative samples (frames without a measurement)
+internal Benchmark_Stats
+benchmark_compute_stats(const float32 *samples, u32 count) {
+	Benchmark_Stats stats = {};
+
+	float32 *sorted = ARRAY_MALLOC(float32, count ? count : 1);
+	for (u32 i = 0; i < count; i++) {
+		if (samples[i] >= 0.0f)
+			sorted[stats.samples_count++] = samples[i];
+	}
+
+	if (stats.samples_count == 0) {
+		platform_free(sorted);
+		return stats;
+	}
+
+	qsort(sorted, stats.samples_count, sizeof(float32), benchmark_compare_float32);
+
+	float64 sum = 0.0;
+	for (u32 i = 0; i < stats.samples_count; i++) {
+		sum += sorted[i];
+
+		u32 bucket = (u32)(sorted[i] / BENCHMARK_BUCKET_WIDTH_MS);
+		if (bucket >= BENCHMARK_HISTOGRAM_BUCKETS)
+			bucket = BENCHMARK_HISTOGRAM_BUCKETS - 1;
+		stats.histogram[bucket]++;
+	}
+
+	stats.min    = sorted[0];
+	stats.median = benchmark_percentile(sorted, stats.samples_count, 0.50f);
+	stats.p95    = benchmark_percentile(sorted, stats.samples_count, 0.95f);
+	stats.p99    = benchmark_percentile(sorted, stats.samples_count, 0.99f);
+	stats.max    = sorted[stats.samples_count - 1];
+	stats.mean   = (float32)(sum / (float64)stats.samples_count);
+
+	platform_free(sorted);
+	return stats;
+}
+
+internal void
+benchmark_append_stats(char *buffer, u32 buffer_size, u32 *length, const char *name, const Benchmark_Stats *stats, bool8 last) {
+	char_array_appendf(buffer, buffer_size, length, "  \"%s\": {\n", name);
+	char_array_appendf(buffer, buffer_size, length, "    \"samples\": %u,\n", stats->samples_count);
+	char_array_appendf(buffer, buffer_size, length, "    \"min\": %.4f,\n", stats->min);
+	char_array_appendf(buffer, buffer_size, length, "    \"median\": %.4f,\n", stats->median);
+	char_array_appendf(buffer, buffer_size, length, "    \"p95\": %.4f,\n", stats->p95);
+	char_array_appendf(buffer, buffer_size, length, "    \"p99\": %.4f,\n", stats->p99);
+	char_array_appendf(buffer, buffer_size, length, "    \"max\": %.4f,\n", stats->max);
+	char_array_appendf(buffer, buffer_size, length, "    \"mean\": %.4f,\n", stats->mean);
+	char_array_appendf(buffer, buffer_size, length, "    \"histogram\": [");
+	for (u32 i = 0; i < BENCHMARK_HISTOGRAM_BUCKETS; i++)
+		char_array_appendf(buffer, buffer_size, length, i ? ", %u" : "%u", stats->histogram[i]);
+	char_array_appendf(buffer, buffer_size, length, "]\n  }%s\n", last ? "" : ",");
+}
+
+internal bool8
+benchmark_write_json(Benchmark *bench) {
+	Benchmark_Stats cpu = benchmark_compute_stats(bench->cpu_ms, bench->recorded_count);
+	Benchmark_Stats gpu = benchmark_compute_stats(bench->gpu_ms, bench->recorded_count);
+
+	u32 buffer_size = 8192;
+	char *buffer = (char*)platform_malloc(buffer_size);
+	u32 length = 0;
+
+	char_array_appendf(buffer, buffer_size, &length, "{\n");
+	char_array_appendf(buffer, buffer_size, &length, "  \"frames\": %u,\n", bench->recorded_count);
+	char_array_appendf(buffer, buffer_size, &length, "  \"histogram_bucket_ms\": %.4f,\n", BENCHMARK_BUCKET_WIDTH_MS);
+	benchmark_append_stats(buffer, buffer_size, &length, "cpu_ms", &cpu, gpu.samples_count == 0);
+	if (gpu.samples_count)
+		benchmark_append_stats(buffer, buffer_size, &length, "gpu_ms", &gpu, true);
+	char_array_appendf(buffer, buffer_size, &length, "}\n");
+
+	if (length >= buffer_size) {
+		logprint("benchmark_write_json()", "json was truncated\n");
+		length = buffer_size - 1;
+	}
+
+	bool8 result = save_file(bench->output_filepath, buffer, length);
+	if (!result) {
+		logprint("benchmark_write_json()", "failed to write %s\n", bench->output_filepath);
+	}
+
+	print("benchmark: %u frames, median %f ms, p99 %f ms, max %f ms\n", bench->recorded_count, cpu.median, cpu.p99, cpu.max);
+
+	platform_free(buffer);
+	return result;
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,418 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+//
+// Block Compression
+//
+
+// encodes 8 bit rgba pixels into BC1, BC3 and BC7 (mode 6 only) 4x4 blocks.
+// the endpoints come from the principal axis of each block, so this is a fast
+// encoder for cooking, not a high quality one. blocks on the right and bottom
+// edge repeat the last pixel. bounds and projections use SSE2 if it is there.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+#define BLOCK_PIXELS 16
+
+typedef void Block_Encode(const u8 *block, u8 *out);
+
+// block is 16 rgba pixels, row after row
+internal void
+block_load(const u8 *pixels, u32 width, u32 height, u32 block_x, u32 block_y, u8 *block) {
+	for (u32 y = 0; y < 4; y++) {
+		u32 source_y = block_y + y;
+		if (source_y >= height) source_y = height - 1;
+		for (u32 x = 0; x < 4; x++) {
+			u32 source_x = block_x + x;
+			if (source_x >= width) source_x = width - 1;
+			*(u32*)(block + (y * 4 + x) * 4) = *(const u32*)(pixels + (source_y * width + source_x) * 4);
+		}
+	}
+}
+
+internal void
+block_bounds(const u8 *block, u8 *min, u8 *max) {
+#ifdef BLOCK_COMPRESSION_SSE2
+	__m128i low = _mm_loadu_si128((const __m128i*)block);
+	__m128i high = low;
+	for (u32 i = 1; i < 4; i++) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(block + i * 16));
+		low = _mm_min_epu8(low, pixels);
+		high = _mm_max_epu8(high, pixels);
+	}
+	// fold the four pixels of each register into one
+	low = _mm_min_epu8(low, _mm_srli_si128(low, 8));
+	low = _mm_min_epu8(low, _mm_srli_si128(low, 4));
+	high = _mm_max_epu8(high, _mm_srli_si128(high, 8));
+	high = _mm_max_epu8(high, _mm_srli_si128(high, 4));
+	*(u32*)min = (u32)_mm_cvtsi128_si32(low);
+	*(u32*)max = (u32)_mm_cvtsi128_si32(high);
+#else
+	for (u32 c = 0; c < 4; c++) {
+		min[c] = 255;
+		max[c] = 0;
+	}
+	for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+		for (u32 c = 0; c < 4; c++) {
+			u8 value = block[i * 4 + c];
+			if (value < min[c]) min[c] = value;
+			if (value > max[c]) max[c] = value;
+		}
+	}
+#endif
+}
+
+// dot product of every pixel with axis. the axis has to fit in s16.
+internal void
+block_project(const u8 *block, const s32 *axis, s32 *dots) {
+#ifdef BLOCK_COMPRESSION_SSE2
+	__m128i zero = _mm_setzero_si128();
+	__m128i weights = _mm_set_epi16((s16)axis[3], (s16)axis[2], (s16)axis[1], (s16)axis[0],
+	                                 (s16)axis[3], (s16)axis[2], (s16)axis[1], (s16)axis[0]);
+	for (u32 i = 0; i < 4; i++) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(block + i * 16));
+		__m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);  // rg, ba of pixel 0 and 1
+		__m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights); // rg, ba of pixel 2 and 3
+		__m128 rg = _mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 ba = _mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_si128((__m128i*)(dots + i * 4), _mm_add_epi32(_mm_castps_si128(rg), _mm_castps_si128(ba)));
+	}
+#else
+	for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+		const u8 *pixel = block + i * 4;
+		dots[i] = pixel[0] * axis[0] + pixel[1] * axis[1] + pixel[2] * axis[2] + pixel[3] * axis[3];
+	}
+#endif
+}
+
+// principal axis of the first channels_count channels, scaled to fit block_project()
+internal void
+block_principal_axis(const u8 *block, u32 channels_count, const u8 *min, const u8 *max, s32 *axis) {
+	float32 mean[4] = {};
+	for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+		for (u32 c = 0; c < channels_count; c++)
+			mean[c] += block[i * 4 + c];
+	}
+	for (u32 c = 0; c < channels_count; c++)
+		mean[c] /= (float32)BLOCK_PIXELS;
+
+	float32 covariance[4][4] = {};
+	for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+		float32 d[4] = {};
+		for (u32 c = 0; c < channels_count; c++)
+			d[c] = (float32)block[i * 4 + c] - mean[c];
+		for (u32 a = 0; a < channels_count; a++) {
+			for (u32 b = 0; b < channels_count; b++)
+				covariance[a][b] += d[a] * d[b];
+		}
+	}
+
+	// power iteration starting at the diagonal of the bounds
+	float32 direction[4] = {};
+	for (u32 c = 0; c < channels_count; c++)
+		direction[c] = (float32)(max[c] - min[c]);
+	for (u32 iteration = 0; iteration < 8; iteration++) {
+		float32 next[4] = {};
+		float32 largest = 0.0f;
+		for (u32 a = 0; a < channels_count; a++) {
+			for (u32 b = 0; b < channels_count; b++)
+				next[a] += covariance[a][b] * direction[b];
+			if (fabsf(next[a]) > largest)
+				largest = fabsf(next[a]);
+		}
+		if (largest == 0.0f)
+			break;
+		for (u32 c = 0; c < channels_count; c++)
+			direction[c] = next[c] / largest;
+	}
+
+	float32 largest = 0.0f;
+	for (u32 c = 0; c < channels_count; c++) {
+		if (fabsf(direction[c]) > largest)
+			largest = fabsf(direction[c]);
+	}
+	for (u32 c = 0; c < 4; c++)
+		axis[c] = (c < channels_count && largest > 0.0f) ? (s32)(direction[c] / largest * 256.0f) : 0;
+}
+
+// the pixels with the smallest and largest projection on the principal axis
+internal void
+block_axis_endpoints(const u8 *block, u32 channels_count, const u8 *min, const u8 *max, u8 *low, u8 *high) {
+	s32 axis[4];
+	block_principal_axis(block, channels_count, min, max, axis);
+
+	s32 dots[BLOCK_PIXELS];
+	block_project(block, axis, dots);
+	u32 low_index = 0;
+	u32 high_index = 0;
+	for (u32 i = 1; i < BLOCK_PIXELS; i++) {
+		if (dots[i] < dots[low_index])  low_index = i;
+		if (dots[i] > dots[high_index]) high_index = i;
+	}
+
+	for (u32 c = 0; c < 4; c++) {
+		low[c] = block[low_index * 4 + c];
+		high[c] = block[high_index * 4 + c];
+	}
+}
+
+//
+// BC1
+//
+
+inline u16
+bc1_pack_565(const s32 *color) {
+	s32 r = (color[0] * 31 + 127) / 255;
+	s32 g = (color[1] * 63 + 127) / 255;
+	s32 b = (color[2] * 31 + 127) / 255;
+	return (u16)((r << 11) | (g << 5) | b);
+}
+
+inline void
+bc1_unpack_565(u16 packed, s32 *color) {
+	s32 r = (packed >> 11) & 31;
+	s32 g = (packed >> 5) & 63;
+	s32 b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 0;
+}
+
+// 8 bytes. always the 4 color mode, alpha is ignored.
+internal void
+bc1_encode_color(const u8 *block, u8 *out) {
+	u8 min[4], max[4];
+	block_bounds(block, min, max);
+
+	u8 low[4], high[4];
+	block_axis_endpoints(block, 3, min, max, low, high);
+
+	// pull the endpoints in a bit so the outliers do not get all of the range
+	s32 endpoints[2][4] = {};
+	for (u32 c = 0; c < 3; c++) {
+		s32 inset = ((s32)high[c] - (s32)low[c]) / 16;
+		endpoints[0][c] = high[c] - inset;
+		endpoints[1][c] = low[c] + inset;
+	}
+
+	u16 color0 = bc1_pack_565(endpoints[0]);
+	u16 color1 = bc1_pack_565(endpoints[1]);
+	if (color0 < color1) {
+		u16 swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	u32 indices = 0;
+	if (color0 != color1) {
+		s32 e0[4], e1[4];
+		bc1_unpack_565(color0, e0);
+		bc1_unpack_565(color1, e1);
+
+		s32 direction[4] = { e1[0] - e0[0], e1[1] - e0[1], e1[2] - e0[2], 0 };
+		s32 length_squared = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+		s32 base = e0[0] * direction[0] + e0[1] * direction[1] + e0[2] * direction[2];
+
+		s32 dots[BLOCK_PIXELS];
+		block_project(block, direction, dots);
+
+		// position on the line from color0 to color1 -> index of the palette entry there
+		const u32 palette_index[4] = { 0, 2, 3, 1 };
+		for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+			s32 step = (length_squared > 0) ? ((dots[i] - base) * 6 + length_squared) / (2 * length_squared) : 0;
+			if (dots[i] < base) step = 0;
+			if (step > 3)       step = 3;
+			indices |= palette_index[step] << (i * 2);
+		}
+	}
+
+	out[0] = (u8)(color0 & 0xFF);
+	out[1] = (u8)(color0 >> 8);
+	out[2] = (u8)(color1 & 0xFF);
+	out[3] = (u8)(color1 >> 8);
+	out[4] = (u8)(indices & 0xFF);
+	out[5] = (u8)((indices >> 8) & 0xFF);
+	out[6] = (u8)((indices >> 16) & 0xFF);
+	out[7] = (u8)(indices >> 24);
+}
+
+internal void
+bc1_encode_block(const u8 *block, u8 *out) {
+	bc1_encode_color(block, out);
+}
+
+//
+// BC3
+//
+
+// 8 bytes. 8 alpha mode: alpha0 > alpha1
+internal void
+bc3_encode_alpha(const u8 *block, u8 *out) {
+	u8 min[4], max[4];
+	block_bounds(block, min, max);
+	s32 alpha0 = max[3];
+	s32 alpha1 = min[3];
+
+	u64 indices = 0;
+	if (alpha0 != alpha1) {
+		s32 range = alpha0 - alpha1;
+		for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+			// steps from alpha0: 0 is index 0, 7 is index 1 and the ones in between are 2 to 7
+			s32 step = ((alpha0 - (s32)block[i * 4 + 3]) * 14 + range) / (2 * range);
+			u64 index = (step == 0) ? 0 : (step == 7) ? 1 : (u64)(step + 1);
+			indices |= index << (i * 3);
+		}
+	}
+
+	out[0] = (u8)alpha0;
+	out[1] = (u8)alpha1;
+	for (u32 i = 0; i < 6; i++)
+		out[2 + i] = (u8)((indices >> (i * 8)) & 0xFF);
+}
+
+// 16 bytes: alpha then color
+internal void
+bc3_encode_block(const u8 *block, u8 *out) {
+	bc3_encode_alpha(block, out);
+	bc1_encode_color(block, out + 8);
+}
+
+//
+// BC7
+//
+
+global const s32 bc7_weights_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// out has to be zeroed
+inline void
+bc7_write_bits(u8 *out, u32 *position, u32 value, u32 bits_count) {
+	for (u32 i = 0; i < bits_count; i++) {
+		u32 bit = *position + i;
+		out[bit / 8] |= (u8)(((value >> i) & 1) << (bit % 8));
+	}
+	*position += bits_count;
+}
+
+// 7 bit endpoint + shared p bit. picks the p bit with the smaller error.
+internal void
+bc7_quantize_endpoint(const s32 *color, s32 *quantized, s32 *p_bit) {
+	s32 best_error = -1;
+	for (s32 p = 0; p < 2; p++) {
+		s32 error = 0;
+		s32 values[4];
+		for (u32 c = 0; c < 4; c++) {
+			s32 value = (color[c] - p + 1) >> 1;
+			if (value < 0)   value = 0;
+			if (value > 127) value = 127;
+			values[c] = value;
+			s32 difference = ((value << 1) | p) - color[c];
+			error += difference * difference;
+		}
+		if (best_error < 0 || error < best_error) {
+			best_error = error;
+			*p_bit = p;
+			for (u32 c = 0; c < 4; c++)
+				quantized[c] = values[c];
+		}
+	}
+}
+
+// 16 bytes. mode 6: one subset, rgba 7.7.7.7 endpoints with p bits, 4 bit indices
+internal void
+bc7_encode_block(const u8 *block, u8 *out) {
+	u8 min[4], max[4];
+	block_bounds(block, min, max);
+
+	u8 low[4], high[4];
+	block_axis_endpoints(block, 4, min, max, low, high);
+
+	s32 endpoints[2][4];
+	for (u32 c = 0; c < 4; c++) {
+		s32 inset = ((s32)high[c] - (s32)low[c]) / 32;
+		endpoints[0][c] = low[c] + inset;
+		endpoints[1][c] = high[c] - inset;
+	}
+
+	s32 quantized[2][4];
+	s32 p_bits[2];
+	bc7_quantize_endpoint(endpoints[0], quantized[0], &p_bits[0]);
+	bc7_quantize_endpoint(endpoints[1], quantized[1], &p_bits[1]);
+
+	s32 e0[4], e1[4], direction[4];
+	s32 length_squared = 0;
+	s32 base = 0;
+	for (u32 c = 0; c < 4; c++) {
+		e0[c] = (quantized[0][c] << 1) | p_bits[0];
+		e1[c] = (quantized[1][c] << 1) | p_bits[1];
+		direction[c] = e1[c] - e0[c];
+		length_squared += direction[c] * direction[c];
+		base += e0[c] * direction[c];
+	}
+
+	u32 indices[BLOCK_PIXELS] = {};
+	if (length_squared > 0) {
+		s32 dots[BLOCK_PIXELS];
+		block_project(block, direction, dots);
+		for (u32 i = 0; i < BLOCK_PIXELS; i++) {
+			s32 weight = ((dots[i] - base) * 128 + length_squared) / (2 * length_squared); // 0 to 64
+			if (dots[i] < base) weight = 0;
+			if (weight > 64)    weight = 64;
+
+			u32 index = 0;
+			while (index < 15 && bc7_weights_4[index + 1] - weight < weight - bc7_weights_4[index])
+				index++;
+			indices[i] = index;
+		}
+	}
+
+	// the msb of the first index is implied 0: swap the endpoints if it is 1
+	if (indices[0] & 8) {
+		for (u32 c = 0; c < 4; c++) {
+			s32 swap = quantized[0][c];
+			quantized[0][c] = quantized[1][c];
+			quantized[1][c] = swap;
+		}
+		s32 swap = p_bits[0];
+		p_bits[0] = p_bits[1];
+		p_bits[1] = swap;
+		for (u32 i = 0; i < BLOCK_PIXELS; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	for (u32 i = 0; i < 16; i++)
+		out[i] = 0;
+	u32 position = 0;
+	bc7_write_bits(out, &position, 1 << 6, 7); // mode 6
+	for (u32 c = 0; c < 4; c++) {
+		bc7_write_bits(out, &position, quantized[0][c], 7);
+		bc7_write_bits(out, &position, quantized[1][c], 7);
+	}
+	bc7_write_bits(out, &position, p_bits[0], 1);
+	bc7_write_bits(out, &position, p_bits[1], 1);
+	bc7_write_bits(out, &position, indices[0], 3);
+	for (u32 i = 1; i < BLOCK_PIXELS; i++)
+		bc7_write_bits(out, &position, indices[i], 4);
+}
+
+//
+// Image
+//
+
+// compresses a whole level. out gets ceil(width / 4) * ceil(height / 4) * block_size bytes.
+internal void
+block_compress(const u8 *pixels, u32 width, u32 height, Block_Encode *encode, u32 block_size, u8 *out) {
+	u8 block[BLOCK_PIXELS * 4];
+	for (u32 y = 0; y < height; y += 4) {
+		for (u32 x = 0; x < width; x += 4) {
+			block_load(pixels, width, height, x, y, block);
+			encode(block, out);
+			out += block_size;
+		}
+	}
+}
+
+#endif // BLOCK_COMPRESSION_H
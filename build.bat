@@ -21,5 +21,9 @@ set LF_VULKAN= ..\VulkanSDK\1.3.268.0\Lib\vulkan-1.lib ..\VulkanSDK\1.3.268.0\Li
 cl %CF_DEFAULT% %CF_SDL% %CF_VULKAN% -DWINDOWS -DSDL -DVULKAN -DDEBUG ../sdl_application.cpp /link %LF_DEFAULT% %LF_SDL% %LF_VULKAN% /out:vulkan.exe
 cl %CF_DEFAULT% %CF_SDL% %CF_OPENGL% -DWINDOWS -DSDL -DOPENGL -DDEBUG ../sdl_application.cpp /link %LF_DEFAULT% %LF_SDL% %LF_OPENGL% /out:opengl.exe
 
+REM pack the assets. the application loads them from assets.pack if it is there
+cl %CF_DEFAULT% -DWINDOWS ../packer.cpp /link -incremental:no -opt:ref -subsystem:console /out:packer.exe
+packer.exe assets.pack ../assets
+
 
 IF NOT EXIST SDL2.dll copy ..\sdl-vc\lib\x64\SDL2.dll
\ No newline at end of file
@@ -230,6 +230,25 @@ float_to_char_array(float32 f, char *buffer, u32 buffer_size) {
     if (ret >= buffer_size) logprint("float_to_char_array(float32 f, char *buffer, u32 buffer_size)", "ftos(): result was truncated");
 }
 
+// appends to buffer and moves length along. stops writing once the buffer is full,
+// so length >= buffer_size means the result was truncated.
+internal void
+char_array_appendf(char *buffer, u32 buffer_size, u32 *length, const char *format, ...) {
+    if (*length >= buffer_size)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    s32 written = vsnprintf(buffer + *length, buffer_size - *length, format, args);
+    va_end(args);
+
+    if (written < 0)
+        return;
+    *length += (u32)written;
+    if (*length > buffer_size)
+        *length = buffer_size;
+}
+
 // char_array_to_float
 
 #define MAX_POWER 20
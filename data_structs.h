@@ -39,4 +39,21 @@ public:
 			platform_free(data);
 		data = (T*)platform_malloc(data_size);
 	}
-};
\ No newline at end of file
+};
+//
+// Hashing
+//
+
+#define FNV_64_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_64_PRIME        0x100000001b3ULL
+
+// FNV-1a. pass the result back in as hash to continue hashing more data.
+inline u64
+fnv1a_64(const void *data, u32 size, u64 hash = FNV_64_OFFSET_BASIS) {
+	const u8 *bytes = (const u8*)data;
+	for (u32 i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_64_PRIME;
+	}
+	return hash;
+}
@@ -86,32 +86,152 @@ void opengl_init_mesh(Mesh *mesh) {
     
     glBufferData(GL_ARRAY_BUFFER, mesh->vertices_count * sizeof(Vertex), &mesh->vertices[0], GL_STATIC_DRAW);  
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indices_count * sizeof(u32), &mesh->indices[0], GL_STATIC_DRAW);
+
+    // per instance transform (one column per location). only enabled during instanced draws.
+    if (opengl_info.instance_vbo == 0)
+        glGenBuffers(1, &opengl_info.instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, opengl_info.instance_vbo);
+    for (u32 i = 0; i < 4; i++) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix_4x4), (void*)(i * sizeof(Vector4)));
+        glVertexAttribDivisor(3 + i, 1);
+    }
     
     glBindVertexArray(0);
 
     mesh->gpu_info = (void*)gl_mesh;
 }
 
+void opengl_free_mesh(Mesh *mesh) {
+    OpenGL_Mesh *gl_mesh = (OpenGL_Mesh*)mesh->gpu_info;
+    if (gl_mesh == 0)
+        return;
+
+    glDeleteBuffers(1, &gl_mesh->vbo);
+    glDeleteBuffers(1, &gl_mesh->ebo);
+    glDeleteVertexArrays(1, &gl_mesh->vao);
+}
+
 void opengl_draw_mesh(Mesh *mesh) {
     OpenGL_Mesh *gl_mesh = (OpenGL_Mesh*)mesh->gpu_info;
     glBindVertexArray(gl_mesh->vao);
+
+    // instance arrays are disabled so the shader reads these constants
+    for (u32 i = 0; i < 4; i++)
+        glVertexAttrib4f(3 + i, (i == 0) ? 1.0f : 0.0f, (i == 1) ? 1.0f : 0.0f, (i == 2) ? 1.0f : 0.0f, (i == 3) ? 1.0f : 0.0f);
+
     glDrawElements(GL_TRIANGLES, mesh->indices_count, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
 
-enum Texture_Parameters
-{
-    TEXTURE_PARAMETERS_DEFAULT,
-    TEXTURE_PARAMETERS_CHAR,
-};
+void opengl_draw_mesh_instanced(Mesh *mesh, const Matrix_4x4 *transforms, u32 count) {
+    if (count == 0)
+        return;
 
-internal void
-opengl_init_bitmap_handle(Bitmap *bitmap, u32 texture_parameters)
+    // orphan the buffer so the driver does not wait on the previous draw that used it
+    glBindBuffer(GL_ARRAY_BUFFER, opengl_info.instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(Matrix_4x4), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Matrix_4x4), transforms);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    OpenGL_Mesh *gl_mesh = (OpenGL_Mesh*)mesh->gpu_info;
+    glBindVertexArray(gl_mesh->vao);
+    for (u32 i = 0; i < 4; i++) glEnableVertexAttribArray(3 + i);
+    glDrawElementsInstanced(GL_TRIANGLES, mesh->indices_count, GL_UNSIGNED_INT, 0, count);
+    for (u32 i = 0; i < 4; i++) glDisableVertexAttribArray(3 + i);
+    glBindVertexArray(0);
+}
+
+//
+// Draw List
+//
+
+// the draw is issued by opengl_draw_list_submit()
+void opengl_draw_list_add(Mesh *mesh, const Matrix_4x4 *transform) {
+    OpenGL_Draw_List *list = &opengl_info.draw_list;
+    if (list->draws_count >= list->draws_capacity) {
+        u32 new_capacity = (list->draws_capacity == 0) ? 64 : (list->draws_capacity * 2);
+        OpenGL_Draw *new_draws = ARRAY_MALLOC(OpenGL_Draw, new_capacity);
+        if (list->draws != 0) {
+            platform_memory_copy(new_draws, list->draws, list->draws_count * sizeof(OpenGL_Draw));
+            platform_free(list->draws);
+            platform_free(list->commands);
+            platform_free(list->transforms);
+        }
+        list->draws = new_draws;
+        list->commands = ARRAY_MALLOC(OpenGL_Draw_Elements_Indirect_Command, new_capacity);
+        list->transforms = ARRAY_MALLOC(Matrix_4x4, new_capacity);
+        list->draws_capacity = new_capacity;
+    }
+
+    OpenGL_Draw *draw = &list->draws[list->draws_count++];
+    draw->vao = ((OpenGL_Mesh*)mesh->gpu_info)->vao;
+    draw->indices_count = mesh->indices_count;
+    draw->transform = *transform;
+}
+
+// every mesh has its own buffers so runs of draws with the same mesh become one
+// glMultiDrawElementsIndirect. add the draws of a mesh together to get fewer calls.
+void opengl_draw_list_submit() {
+    OpenGL_Draw_List *list = &opengl_info.draw_list;
+    if (list->draws_count == 0)
+        return;
+
+    for (u32 i = 0; i < list->draws_count; i++) {
+        OpenGL_Draw_Elements_Indirect_Command *command = &list->commands[i];
+        command->count = list->draws[i].indices_count;
+        command->instance_count = 1;
+        command->first_index = 0;
+        command->base_vertex = 0;
+        command->base_instance = i; // picks the transform
+        list->transforms[i] = list->draws[i].transform;
+    }
+
+    if (opengl_info.indirect_buffer == 0)
+        glGenBuffers(1, &opengl_info.indirect_buffer);
+
+    // orphan both so the driver does not wait on the last submit
+    glBindBuffer(GL_ARRAY_BUFFER, opengl_info.instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, list->draws_count * sizeof(Matrix_4x4), list->transforms, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, opengl_info.indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, list->draws_count * sizeof(OpenGL_Draw_Elements_Indirect_Command), list->commands, GL_STREAM_DRAW);
+
+    u32 run_start = 0;
+    for (u32 i = 1; i <= list->draws_count; i++) {
+        if (i < list->draws_count && list->draws[i].vao == list->draws[run_start].vao)
+            continue;
+
+        glBindVertexArray(list->draws[run_start].vao);
+        for (u32 column = 0; column < 4; column++) glEnableVertexAttribArray(3 + column);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(run_start * sizeof(OpenGL_Draw_Elements_Indirect_Command)), i - run_start, 0);
+        for (u32 column = 0; column < 4; column++) glDisableVertexAttribArray(3 + column);
+
+        run_start = i;
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    list->draws_count = 0;
+}
+
+// gpu markers only exist in vulkan
+void opengl_gpu_marker_begin(const char *name) {}
+void opengl_gpu_marker_end() {}
+float32 opengl_gpu_frame_time() { return -1.0f; }
+
+// block compressed bitmaps are only uploaded by vulkan
+u32 opengl_texture_formats() { return TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_PIXELS); }
+
+// gpu_handle points to the texture name (u32)
+void opengl_init_bitmap(Bitmap *bitmap, u32 texture_parameters)
 {
     GLenum target = GL_TEXTURE_2D;
     
-    glGenTextures(1, &bitmap->handle);
-    glBindTexture(target, bitmap->handle);
+    u32 *handle = (u32*)platform_malloc(sizeof(u32));
+    glGenTextures(1, handle);
+    glBindTexture(target, *handle);
+    bitmap->gpu_handle = (void*)handle;
     
     GLint internal_format = 0;
     GLenum data_format = 0;
@@ -139,7 +259,20 @@ opengl_init_bitmap_handle(Bitmap *bitmap, u32 texture_parameters)
     
     glPixelStorei(GL_UNPACK_ALIGNMENT, pixel_unpack_alignment);
     glTexImage2D(target, 0, internal_format, bitmap->dim.width, bitmap->dim.height, 0, data_format, GL_UNSIGNED_BYTE, bitmap->memory);
-    glGenerateMipmap(target);
+    if (bitmap->mip_levels > 1) {
+        // cooked bitmaps bring their levels along
+        s32 width = bitmap->width;
+        s32 height = bitmap->height;
+        u8 *level_memory = bitmap->memory;
+        for (u32 level = 1; level < bitmap->mip_levels; level++) {
+            level_memory += texture_level_size(bitmap->format, bitmap->channels, width, height);
+            width = (width > 1) ? width / 2 : 1;
+            height = (height > 1) ? height / 2 : 1;
+            glTexImage2D(target, level, internal_format, width, height, 0, data_format, GL_UNSIGNED_BYTE, level_memory);
+        }
+    } else {
+        glGenerateMipmap(target);
+    }
     
     switch(texture_parameters) {
         case TEXTURE_PARAMETERS_DEFAULT:
@@ -159,3 +292,20 @@ opengl_init_bitmap_handle(Bitmap *bitmap, u32 texture_parameters)
     
     glBindTexture(target, 0);
 }
+
+void opengl_free_bitmap(Bitmap *bitmap)
+{
+    if (bitmap->gpu_handle == 0)
+        return;
+
+    glDeleteTextures(1, (u32*)bitmap->gpu_handle);
+    platform_free(bitmap->gpu_handle);
+    bitmap->gpu_handle = 0;
+}
+
+// the draws after this sample bitmap. 0 unbinds.
+void opengl_bind_bitmap(Bitmap *bitmap)
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, (bitmap && bitmap->gpu_handle) ? *(u32*)bitmap->gpu_handle : 0);
+}
@@ -4,10 +4,38 @@ struct OpenGL_Mesh {
     u32 ebo; // element array buffer object (index buffer object)
 };
 
+// layout of the commands read by glMultiDrawElementsIndirect
+struct OpenGL_Draw_Elements_Indirect_Command {
+    u32 count;
+    u32 instance_count;
+    u32 first_index;
+    s32 base_vertex;
+    u32 base_instance;
+};
+
+struct OpenGL_Draw {
+    u32 vao;
+    u32 indices_count;
+    Matrix_4x4 transform;
+};
+
+struct OpenGL_Draw_List {
+    OpenGL_Draw *draws;
+    u32 draws_count;
+    u32 draws_capacity;
+
+    OpenGL_Draw_Elements_Indirect_Command *commands; // same capacity as draws
+    Matrix_4x4 *transforms;
+};
+
 struct OpenGL_Info {
 #ifdef SDL
     SDL_Window *sdl_window;
 #endif // SDL
+
+    u32 instance_vbo; // per instance transforms of the current instanced draw
+    u32 indirect_buffer;
+    OpenGL_Draw_List draw_list;
 };
 
 global OpenGL_Info opengl_info;
@@ -0,0 +1,491 @@
+#ifndef PACK_H
+#define PACK_H
+
+//
+// Pack
+//
+
+// many asset files in one. the table of contents is a hash table keyed by the fnv1a_64
+// of the path, so finding a file is a hash and a probe or two. entries start on
+// PACK_ALIGNMENT, so a mapped pack can hand out stored entries in place. entries that
+// get smaller with the LZ compressor below are stored compressed.
+//
+// layout: Pack_Header | entries | names | table of contents
+// paths are compared with '/' and '\' being the same.
+
+#define PACK_MAGIC     0x4B434150 // "PACK"
+#define PACK_VERSION   1
+#define PACK_ALIGNMENT 64
+
+enum Pack_Compression
+{
+    PACK_COMPRESSION_NONE,
+    PACK_COMPRESSION_LZ,
+};
+
+struct Pack_Header {
+	u32 magic;
+	u32 version;
+	u32 entries_count;
+	u32 slots_count;  // in the table of contents. power of 2
+	u32 toc_offset;
+	u32 names_offset;
+	u32 names_size;
+	u32 reserved;
+};
+
+struct Pack_Entry {
+	u64 name_hash;
+	u32 name_offset;  // from names_offset. names are not terminated
+	u32 name_length;  // 0 = empty slot
+	u32 offset;       // from the start of the pack
+	u32 stored_size;
+	u32 size;         // after decompressing
+	u32 compression;  // Pack_Compression
+};
+
+struct Pack {
+	const u8 *memory; // the whole pack. has to stay valid while the pack is used
+	u32 size;
+
+	const Pack_Header *header;
+	const Pack_Entry *slots;
+	const char *names;
+};
+
+inline char
+pack_name_char(char c) {
+	return (c == '\\') ? '/' : c;
+}
+
+inline u64
+pack_hash_name(const char *name, u32 length) {
+	u64 hash = FNV_64_OFFSET_BASIS;
+	for (u32 i = 0; i < length; i++) {
+		hash ^= (u8)pack_name_char(name[i]);
+		hash *= FNV_64_PRIME;
+	}
+	return hash;
+}
+
+inline bool8
+pack_name_equal(const char *a, const char *b, u32 length) {
+	for (u32 i = 0; i < length; i++) {
+		if (pack_name_char(a[i]) != pack_name_char(b[i]))
+			return false;
+	}
+	return true;
+}
+
+//
+// LZ
+//
+
+// the lz4 block format: a token with the literal and match length, the literals,
+// a 16 bit offset back into the output and the match. fast to decompress, and the
+// greedy compressor below only keeps the last position of every 4 byte hash.
+
+#define PACK_LZ_MIN_MATCH     4
+#define PACK_LZ_HASH_BITS     14
+#define PACK_LZ_MAX_OFFSET    65535
+#define PACK_LZ_LAST_LITERALS 5  // the end of the input is always literals
+#define PACK_LZ_MATCH_LIMIT   12 // no match starts closer to the end than this
+
+// biggest size the compressed data can have
+inline u32
+pack_lz_bound(u32 size) {
+	return size + size / 255 + 16;
+}
+
+inline u32
+pack_lz_read_u32(const u8 *memory) {
+	u32 value;
+	memcpy(&value, memory, sizeof(value));
+	return value;
+}
+
+inline void
+pack_lz_write_length(u8 **out, u32 length) {
+	while (length >= 255) {
+		*(*out)++ = 255;
+		length -= 255;
+	}
+	*(*out)++ = (u8)length;
+}
+
+internal u8*
+pack_lz_write_sequence(u8 *out, const u8 *literals, u32 literals_count, u32 offset, u32 match_length) {
+	u8 *token = out++;
+	u32 match_code = (match_length >= PACK_LZ_MIN_MATCH) ? match_length - PACK_LZ_MIN_MATCH : 0;
+	*token = (u8)(((literals_count < 15) ? literals_count : 15) << 4);
+	if (literals_count >= 15)
+		pack_lz_write_length(&out, literals_count - 15);
+	memcpy(out, literals, literals_count);
+	out += literals_count;
+
+	if (match_length == 0)
+		return out; // last sequence
+
+	*token |= (u8)((match_code < 15) ? match_code : 15);
+	*out++ = (u8)(offset & 0xFF);
+	*out++ = (u8)(offset >> 8);
+	if (match_code >= 15)
+		pack_lz_write_length(&out, match_code - 15);
+	return out;
+}
+
+// returns the compressed size. out needs pack_lz_bound(size) bytes.
+internal u32
+pack_lz_compress(const u8 *in, u32 size, u8 *out) {
+	u8 *out_start = out;
+	u32 table_size = sizeof(u32) << PACK_LZ_HASH_BITS;
+	u32 *table = (u32*)platform_malloc(table_size); // position + 1 of the last 4 bytes with that hash
+	platform_memory_set(table, 0, table_size);
+
+	u32 anchor = 0; // the literals since the last match start here
+	u32 position = 0;
+	if (size > PACK_LZ_MATCH_LIMIT) {
+		u32 limit = size - PACK_LZ_MATCH_LIMIT;
+		while (position < limit) {
+			u32 sequence = pack_lz_read_u32(in + position);
+			u32 hash = (sequence * 2654435761u) >> (32 - PACK_LZ_HASH_BITS);
+			u32 candidate = table[hash];
+			table[hash] = position + 1;
+
+			if (candidate == 0 || position - (candidate - 1) > PACK_LZ_MAX_OFFSET || pack_lz_read_u32(in + candidate - 1) != sequence) {
+				position++;
+				continue;
+			}
+
+			u32 match = candidate - 1;
+			u32 match_end = position + PACK_LZ_MIN_MATCH;
+			while (match_end < size - PACK_LZ_LAST_LITERALS && in[match_end] == in[match + (match_end - position)])
+				match_end++;
+
+			out = pack_lz_write_sequence(out, in + anchor, position - anchor, position - match, match_end - position);
+			position = match_end;
+			anchor = position;
+		}
+	}
+	out = pack_lz_write_sequence(out, in + anchor, size - anchor, 0, 0);
+
+	platform_free(table);
+	return (u32)(out - out_start);
+}
+
+inline bool8
+pack_lz_read_length(const u8 **in, const u8 *in_end, u32 *length) {
+	u8 byte;
+	do {
+		if (*in >= in_end)
+			return false;
+		byte = *(*in)++;
+		*length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+// returns false if the data is broken. out has to be the size before compressing.
+internal bool8
+pack_lz_decompress(const u8 *in, u32 in_size, u8 *out, u32 out_size) {
+	const u8 *in_end = in + in_size;
+	u32 written = 0;
+
+	while (in < in_end) {
+		u8 token = *in++;
+
+		u32 literals_count = token >> 4;
+		if (literals_count == 15 && !pack_lz_read_length(&in, in_end, &literals_count))
+			return false;
+		if (literals_count > (u32)(in_end - in) || literals_count > out_size - written)
+			return false;
+		memcpy(out + written, in, literals_count);
+		in += literals_count;
+		written += literals_count;
+
+		if (in == in_end)
+			break; // the last sequence has no match
+
+		if (in_end - in < 2)
+			return false;
+		u32 offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > written)
+			return false;
+
+		u32 match_length = token & 15;
+		if (match_length == 15 && !pack_lz_read_length(&in, in_end, &match_length))
+			return false;
+		match_length += PACK_LZ_MIN_MATCH;
+		if (match_length > out_size - written)
+			return false;
+
+		// the match can overlap what it writes
+		u8 *dest = out + written;
+		const u8 *source = dest - offset;
+		for (u32 i = 0; i < match_length; i++)
+			dest[i] = source[i];
+		written += match_length;
+	}
+
+	return written == out_size;
+}
+
+//
+// Reading
+//
+
+// checks that everything the header points to is inside of memory
+internal bool8
+pack_open(Pack *pack, const void *memory, u32 size) {
+	*pack = {};
+	const Pack_Header *header = (const Pack_Header*)memory;
+	if (size < sizeof(Pack_Header) || header->magic != PACK_MAGIC || header->version != PACK_VERSION)
+		return false;
+
+	u32 slots_count = header->slots_count;
+	bool8 valid = slots_count != 0 && (slots_count & (slots_count - 1)) == 0 &&
+	              header->entries_count < slots_count &&
+	              header->toc_offset % sizeof(u64) == 0 &&
+	              (u64)header->toc_offset + (u64)slots_count * sizeof(Pack_Entry) <= size &&
+	              (u64)header->names_offset + header->names_size <= size;
+	if (!valid)
+		return false;
+
+	const Pack_Entry *slots = (const Pack_Entry*)((const u8*)memory + header->toc_offset);
+	u32 used_slots = 0;
+	for (u32 i = 0; i < slots_count; i++) {
+		const Pack_Entry *entry = &slots[i];
+		if (entry->name_length == 0)
+			continue;
+		if ((u64)entry->offset + entry->stored_size > size ||
+		    (u64)entry->name_offset + entry->name_length > header->names_size)
+			return false;
+		// stored entries are handed out in place with their size, so that has to be inside too
+		if (entry->compression == PACK_COMPRESSION_NONE) {
+			if (entry->stored_size != entry->size)
+				return false;
+		} else if (entry->compression != PACK_COMPRESSION_LZ) {
+			return false;
+		}
+		used_slots++;
+	}
+	if (used_slots == slots_count)
+		return false; // pack_find() stops at an empty slot
+
+	pack->memory = (const u8*)memory;
+	pack->size = size;
+	pack->header = header;
+	pack->slots = slots;
+	pack->names = (const char*)memory + header->names_offset;
+	return true;
+}
+
+// returns 0 if name is not in the pack (or no pack is open)
+internal const Pack_Entry*
+pack_find(Pack *pack, const char *name) {
+	if (pack->slots == 0)
+		return 0;
+
+	u32 length = get_length(name);
+	u64 hash = pack_hash_name(name, length);
+	u32 mask = pack->header->slots_count - 1;
+	for (u32 slot = (u32)hash & mask; ; slot = (slot + 1) & mask) {
+		const Pack_Entry *entry = &pack->slots[slot];
+		if (entry->name_length == 0)
+			return 0; // there is always an empty slot
+		if (entry->name_hash == hash && entry->name_length == length && pack_name_equal(pack->names + entry->name_offset, name, length))
+			return entry;
+	}
+}
+
+// stored entries can be used in place
+inline const u8*
+pack_entry_memory(Pack *pack, const Pack_Entry *entry) {
+	return pack->memory + entry->offset;
+}
+
+// copies or decompresses the entry into dest. dest needs entry->size bytes.
+internal bool8
+pack_read_entry(Pack *pack, const Pack_Entry *entry, void *dest) {
+	const u8 *stored = pack_entry_memory(pack, entry);
+	switch(entry->compression) {
+		case PACK_COMPRESSION_NONE: {
+			if (entry->stored_size != entry->size)
+				return false;
+			memcpy(dest, stored, entry->size);
+			return true;
+		}
+		case PACK_COMPRESSION_LZ:
+			return pack_lz_decompress(stored, entry->stored_size, (u8*)dest, entry->size);
+	}
+	return false;
+}
+
+//
+// Writing
+//
+
+struct Pack_Writer {
+	FILE *out;
+	const char *filepath;
+	u32 position;
+
+	Pack_Entry *entries;
+	u32 entries_count;
+	u32 entries_capacity;
+
+	char *names;
+	u32 names_size;
+	u32 names_capacity;
+};
+
+// keeps the memory and doubles the capacity until needed bytes fit
+internal void*
+pack_writer_grow(void *memory, u32 used_bytes, u32 *capacity_bytes, u32 needed_bytes) {
+	if (needed_bytes <= *capacity_bytes)
+		return memory;
+
+	u32 capacity = (*capacity_bytes) ? *capacity_bytes : 1024;
+	while (capacity < needed_bytes)
+		capacity *= 2;
+
+	void *grown = platform_malloc(capacity);
+	if (memory != 0) {
+		platform_memory_copy(grown, memory, used_bytes);
+		platform_free(memory);
+	}
+	*capacity_bytes = capacity;
+	return grown;
+}
+
+internal bool8
+pack_writer_pad(Pack_Writer *writer) {
+	u8 zeros[PACK_ALIGNMENT] = {};
+	u32 padding = (PACK_ALIGNMENT - (writer->position % PACK_ALIGNMENT)) % PACK_ALIGNMENT;
+	if (padding && fwrite(zeros, padding, 1, writer->out) != 1)
+		return false;
+	writer->position += padding;
+	return true;
+}
+
+internal bool8
+pack_writer_begin(Pack_Writer *writer, const char *filepath) {
+	*writer = {};
+	writer->out = fopen(filepath, "wb");
+	if (!writer->out) {
+		logprint("pack_writer_begin()", "Cannot open file %s\n", filepath);
+		return false;
+	}
+	writer->filepath = filepath;
+
+	Pack_Header header = {}; // written again by pack_writer_end()
+	fwrite(&header, sizeof(header), 1, writer->out);
+	writer->position = sizeof(header);
+	return pack_writer_pad(writer);
+}
+
+// the data is compressed if that makes it at least 1/8 smaller
+internal bool8
+pack_writer_add(Pack_Writer *writer, const char *name, const void *data, u32 size, bool8 compress) {
+	u32 name_length = get_length(name);
+	u64 hash = pack_hash_name(name, name_length);
+	for (u32 i = 0; i < writer->entries_count; i++) {
+		Pack_Entry *entry = &writer->entries[i];
+		if (entry->name_hash == hash && entry->name_length == name_length && pack_name_equal(writer->names + entry->name_offset, name, name_length)) {
+			logprint("pack_writer_add()", "%s is in the pack already\n", name);
+			return false;
+		}
+	}
+
+	const void *stored = data;
+	u32 stored_size = size;
+	u32 compression = PACK_COMPRESSION_NONE;
+	u8 *compressed = 0;
+	if (compress && size > 0) {
+		compressed = (u8*)platform_malloc(pack_lz_bound(size));
+		u32 compressed_size = pack_lz_compress((const u8*)data, size, compressed);
+		if (compressed_size < size - size / 8) {
+			stored = compressed;
+			stored_size = compressed_size;
+			compression = PACK_COMPRESSION_LZ;
+		}
+	}
+
+	bool8 written = (stored_size == 0 || fwrite(stored, stored_size, 1, writer->out) == 1);
+	if (compressed != 0)
+		platform_free(compressed);
+	if (!written) {
+		logprint("pack_writer_add()", "Failed to write %s into %s\n", name, writer->filepath);
+		return false;
+	}
+
+	u32 entries_bytes = writer->entries_capacity * sizeof(Pack_Entry);
+	writer->entries = (Pack_Entry*)pack_writer_grow(writer->entries, writer->entries_count * sizeof(Pack_Entry), &entries_bytes, (writer->entries_count + 1) * sizeof(Pack_Entry));
+	writer->entries_capacity = entries_bytes / sizeof(Pack_Entry);
+	writer->names = (char*)pack_writer_grow(writer->names, writer->names_size, &writer->names_capacity, writer->names_size + name_length);
+
+	Pack_Entry *entry = &writer->entries[writer->entries_count++];
+	*entry = {};
+	entry->name_hash = hash;
+	entry->name_offset = writer->names_size;
+	entry->name_length = name_length;
+	entry->offset = writer->position;
+	entry->stored_size = stored_size;
+	entry->size = size;
+	entry->compression = compression;
+
+	for (u32 i = 0; i < name_length; i++)
+		writer->names[writer->names_size + i] = pack_name_char(name[i]);
+	writer->names_size += name_length;
+
+	writer->position += stored_size;
+	return pack_writer_pad(writer);
+}
+
+// writes the names and the table of contents and closes the file
+internal bool8
+pack_writer_end(Pack_Writer *writer) {
+	Pack_Header header = {};
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.entries_count = writer->entries_count;
+
+	// at most half full so probes stay short and there is always an empty slot
+	header.slots_count = 16;
+	while (header.slots_count < writer->entries_count * 2)
+		header.slots_count *= 2;
+
+	u32 slots_size = header.slots_count * sizeof(Pack_Entry);
+	Pack_Entry *slots = (Pack_Entry*)platform_malloc(slots_size);
+	platform_memory_set(slots, 0, slots_size);
+	u32 mask = header.slots_count - 1;
+	for (u32 i = 0; i < writer->entries_count; i++) {
+		u32 slot = (u32)writer->entries[i].name_hash & mask;
+		while (slots[slot].name_length != 0)
+			slot = (slot + 1) & mask;
+		slots[slot] = writer->entries[i];
+	}
+
+	header.names_offset = writer->position;
+	header.names_size = writer->names_size;
+	bool8 result = (writer->names_size == 0 || fwrite(writer->names, writer->names_size, 1, writer->out) == 1);
+	writer->position += writer->names_size;
+	result = result && pack_writer_pad(writer);
+
+	header.toc_offset = writer->position;
+	result = result && fwrite(slots, slots_size, 1, writer->out) == 1;
+	result = result && fseek(writer->out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, writer->out) == 1;
+	fclose(writer->out);
+
+	if (!result)
+		logprint("pack_writer_end()", "Failed to write %s\n", writer->filepath);
+
+	platform_free(slots);
+	if (writer->entries) platform_free(writer->entries);
+	if (writer->names)   platform_free(writer->names);
+	*writer = {};
+	return result;
+}
+
+#endif // PACK_H
@@ -0,0 +1,174 @@
+//
+// Packer
+//
+
+// packer <output.pack> <directory>...
+// puts every file under the directories into one pack. the entry names are the
+// paths as they are passed in, so run it from where the application runs:
+//     packer assets.pack ../assets
+// makes ../assets/bitmaps/yogi.png findable by load_file("../assets/bitmaps/yogi.png").
+// cooked textures are left out, they depend on the gpu and get made next to the sources.
+
+#ifdef WINDOWS
+#define WIN32_EXTRA_LEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif // WINDOWS
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+#include "types.h"
+
+void *platform_malloc(u32 size) { return malloc(size); }
+void platform_free(void *ptr)   { free(ptr); }
+void platform_memory_copy(void *dest, void *src, u32 num_of_bytes) { memcpy(dest, src, num_of_bytes); }
+void platform_memory_set(void *dest, s32 value, u32 num_of_bytes) { memset(dest, value, num_of_bytes); }
+
+#include "print.h"
+#include "char_array.h"
+#include "data_structs.h"
+#include "pack.h"
+
+// print.cpp sends everything to the debugger on windows. packer runs in a console,
+// so the errors from pack.h have to show up there. the formats print() takes are a
+// subset of printf's.
+void print(const char *msg, ...) {
+	va_list list;
+	va_start(list, msg);
+	vfprintf(stdout, msg, list);
+	va_end(list);
+}
+
+void logprint(const char *where, const char *msg, ...) {
+	fprintf(stderr, "%s: ", where);
+	va_list list;
+	va_start(list, msg);
+	vfprintf(stderr, msg, list);
+	va_end(list);
+}
+
+#define PACKER_MAX_PATH 512
+
+struct Packer {
+	Pack_Writer writer;
+	u32 files_count;
+	u64 original_bytes;
+	u64 stored_bytes;
+	bool8 failed;
+};
+
+internal bool8
+packer_skip(const char *filepath) {
+	u32 length = get_length(filepath);
+	const char *extension = ".cooked";
+	u32 extension_length = get_length(extension);
+	return length >= extension_length && equal(filepath + length - extension_length, extension);
+}
+
+internal void
+packer_add_file(Packer *packer, const char *filepath) {
+	if (packer_skip(filepath))
+		return;
+
+	FILE *in = fopen(filepath, "rb");
+	if (!in) {
+		fprintf(stderr, "packer: cannot open %s\n", filepath);
+		packer->failed = true;
+		return;
+	}
+	fseek(in, 0, SEEK_END);
+	u32 size = (u32)ftell(in);
+	fseek(in, 0, SEEK_SET);
+	u8 *memory = (u8*)platform_malloc(size ? size : 1);
+	bool8 read = size == 0 || fread(memory, size, 1, in) == 1;
+	fclose(in);
+
+	if (!read || !pack_writer_add(&packer->writer, filepath, memory, size, true)) {
+		fprintf(stderr, "packer: failed to add %s\n", filepath);
+		packer->failed = true;
+	} else {
+		Pack_Entry *entry = &packer->writer.entries[packer->writer.entries_count - 1];
+		packer->files_count++;
+		packer->original_bytes += entry->size;
+		packer->stored_bytes += entry->stored_size;
+	}
+	platform_free(memory);
+}
+
+internal void
+packer_add_directory(Packer *packer, const char *directory) {
+	char filepath[PACKER_MAX_PATH];
+
+#ifdef WINDOWS
+	snprintf(filepath, sizeof(filepath), "%s/*", directory);
+	WIN32_FIND_DATAA find_data;
+	HANDLE find = FindFirstFileA(filepath, &find_data);
+	if (find == INVALID_HANDLE_VALUE) {
+		fprintf(stderr, "packer: cannot open directory %s\n", directory);
+		packer->failed = true;
+		return;
+	}
+	do {
+		const char *name = find_data.cFileName;
+		if (equal(name, ".") || equal(name, ".."))
+			continue;
+		snprintf(filepath, sizeof(filepath), "%s/%s", directory, name);
+		if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			packer_add_directory(packer, filepath);
+		else
+			packer_add_file(packer, filepath);
+	} while (FindNextFileA(find, &find_data));
+	FindClose(find);
+#else
+	DIR *dir = opendir(directory);
+	if (!dir) {
+		fprintf(stderr, "packer: cannot open directory %s\n", directory);
+		packer->failed = true;
+		return;
+	}
+	struct dirent *dir_entry;
+	while ((dir_entry = readdir(dir)) != 0) {
+		const char *name = dir_entry->d_name;
+		if (equal(name, ".") || equal(name, ".."))
+			continue;
+		snprintf(filepath, sizeof(filepath), "%s/%s", directory, name);
+		struct stat file_stat = {};
+		if (stat(filepath, &file_stat) != 0)
+			continue;
+		if (S_ISDIR(file_stat.st_mode))
+			packer_add_directory(packer, filepath);
+		else if (S_ISREG(file_stat.st_mode))
+			packer_add_file(packer, filepath);
+	}
+	closedir(dir);
+#endif // WINDOWS
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		fprintf(stderr, "usage: packer <output.pack> <directory>...\n");
+		return 1;
+	}
+
+	Packer packer = {};
+	if (!pack_writer_begin(&packer.writer, argv[1]))
+		return 1; // pack_writer_begin() logged why
+
+	for (s32 i = 2; i < argc; i++)
+		packer_add_directory(&packer, argv[i]);
+
+	if (!pack_writer_end(&packer.writer))
+		packer.failed = true;
+
+	printf("packer: %u files, %llu bytes stored as %llu in %s\n", packer.files_count,
+	       (unsigned long long)packer.original_bytes, (unsigned long long)packer.stored_bytes, argv[1]);
+	return packer.failed ? 1 : 0;
+}
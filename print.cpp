@@ -50,6 +50,14 @@ print_list(u32 output_stream, const char *msg, va_list list) {
 					}
 		            copy_char_array(&print_buffer[print_buffer_index], string);
 		        } break;
+		        case 'd': {
+		            s32 d = va_arg(list, s32);
+		            length_to_add = snprintf(&print_buffer[print_buffer_index], PRINT_BUFFER_SIZE - print_buffer_index, "%d", d);
+		        } break;
+		        case 'u': {
+		            u32 u = va_arg(list, u32);
+		            length_to_add = snprintf(&print_buffer[print_buffer_index], PRINT_BUFFER_SIZE - print_buffer_index, "%u", u);
+		        } break;
 		        case 'f': {
 		            double f = va_arg(list, double);
 		            const char *f_string = float_to_char_array((float)f);
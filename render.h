@@ -24,5 +24,16 @@ void (*render_clear_depth_stencil)(float32 depth_value, float32 stencil_value);
 void (*render_start_frame)() = &GPU_EXT(start_frame);
 void (*render_end_frame)() = &GPU_EXT(end_frame);
 void (*render_draw_mesh)(Mesh *mesh) = &GPU_EXT(draw_mesh);
+void (*render_draw_mesh_instanced)(Mesh *mesh, const Matrix_4x4 *transforms, u32 count) = &GPU_EXT(draw_mesh_instanced);
+void (*render_draw_list_add)(Mesh *mesh, const Matrix_4x4 *transform) = &GPU_EXT(draw_list_add);
+void (*render_draw_list_submit)() = &GPU_EXT(draw_list_submit);
 void (*render_init_mesh)(Mesh *mesh) = &GPU_EXT(init_mesh);
+void (*render_free_mesh)(Mesh *mesh) = &GPU_EXT(free_mesh);
+void (*render_init_bitmap)(Bitmap *bitmap, u32 texture_parameters) = &GPU_EXT(init_bitmap);
+void (*render_free_bitmap)(Bitmap *bitmap) = &GPU_EXT(free_bitmap);
+void (*render_bind_bitmap)(Bitmap *bitmap) = &GPU_EXT(bind_bitmap);
+void (*render_gpu_marker_begin)(const char *name) = &GPU_EXT(gpu_marker_begin);
+void (*render_gpu_marker_end)() = &GPU_EXT(gpu_marker_end);
+float32 (*render_gpu_frame_time)() = &GPU_EXT(gpu_frame_time);
+u32 (*render_texture_formats)() = &GPU_EXT(texture_formats);
 void (*render_update_uniform_buffer_object)(Uniform_Buffer_Object ubo, Matrices matrices) = &GPU_EXT(update_uniform_buffer_object);
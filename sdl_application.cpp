@@ -17,6 +17,13 @@ extern "C"
     __declspec(dllexport) DWORD AmdPowerXpressRequestHighPerformance = 0x01;
 }
 
+#else
+
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #endif // WINDOWS
 
 #ifdef OPENGL
@@ -55,6 +62,58 @@ void platform_free(void *ptr)   { SDL_free(ptr); }
 void platform_memory_copy(void *dest, void *src, u32 num_of_bytes) { SDL_memcpy(dest, src, num_of_bytes); }
 void platform_memory_set(void *dest, s32 value, u32 num_of_bytes) { SDL_memset(dest, value, num_of_bytes); }
 
+// does nothing if the directory already exists
+#ifdef WINDOWS
+void platform_create_directory(const char *path) { CreateDirectoryA(path, NULL); }
+#else
+void platform_create_directory(const char *path) { mkdir(path, 0755); }
+#endif // WINDOWS
+
+// read only view of a whole file. returns 0 if it can not be mapped (empty files can not).
+#ifdef WINDOWS
+void *platform_map_file(const char *filepath, u32 *size) {
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    void *memory = 0;
+    LARGE_INTEGER file_size = {};
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && file_size.QuadPart <= 0xFFFFFFFF) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps it open
+        }
+    }
+    CloseHandle(file);
+
+    if (memory != 0)
+        *size = (u32)file_size.QuadPart;
+    return memory;
+}
+void platform_unmap_file(void *memory, u32 size) { UnmapViewOfFile(memory); }
+#else
+void *platform_map_file(const char *filepath, u32 *size) {
+    int file = open(filepath, O_RDONLY);
+    if (file < 0)
+        return 0;
+
+    void *memory = 0;
+    struct stat file_stat = {};
+    if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0 && (u64)file_stat.st_size <= 0xFFFFFFFF) {
+        memory = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (memory == MAP_FAILED)
+            memory = 0;
+    }
+    close(file); // the mapping keeps it open
+
+    if (memory != 0)
+        *size = (u32)file_stat.st_size;
+    return memory;
+}
+void platform_unmap_file(void *memory, u32 size) { munmap(memory, size); }
+#endif // WINDOWS
+
 #define ARRAY_COUNT(n)     (sizeof(n) / sizeof(n[0]))
 #define ARRAY_MALLOC(t, n) ((t*)platform_malloc(n * sizeof(t)))
 
@@ -63,6 +122,10 @@ void platform_memory_set(void *dest, s32 value, u32 num_of_bytes) { SDL_memset(d
 #include "char_array.h"
 #include "assets.h"
 #include "data_structs.h"
+#include "work_queue.h"
+#include "trace.h"
+#include "block_compression.h"
+#include "pack.h"
 
 #ifdef OPENGL
 
@@ -78,6 +141,7 @@ void platform_memory_set(void *dest, s32 value, u32 num_of_bytes) { SDL_memset(d
 
 #include "render.h"
 #include "application.h"
+#include "benchmark.h"
 
 #include "print.cpp"
 #include "assets.cpp"
@@ -147,14 +211,22 @@ update_window(u32 width, u32 height, bool8 minimized)
 
 internal void
 sdl_init_vulkan(Vulkan_Info *info, SDL_Window *sdl_window) {
-    SDL_GetWindowSize(sdl_window, &info->window_width, &info->window_height);
-
-	if (SDL_Vulkan_GetInstanceExtensions(sdl_window, &info->instance_extensions_count, NULL) == SDL_FALSE) {
-		logprint("main", "nullptr SDL_Vulkan_GetInstanceExtensions failed\n");
-	}
-	info->instance_extensions = ARRAY_MALLOC(const char *, info->instance_extensions_count);
-	if (SDL_Vulkan_GetInstanceExtensions(sdl_window, &info->instance_extensions_count, info->instance_extensions) == SDL_FALSE) {
-		logprint("main", "SDL_Vulkan_GetInstanceExtensions failed\n");
+	// headless: no window. window_width and window_height are set by the caller.
+	if (info->headless) {
+		info->instance_extensions_count = 0;
+		info->instance_extensions = ARRAY_MALLOC(const char *, 1);
+		if (info->validation_layers.enable)
+			info->instance_extensions[info->instance_extensions_count++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+	} else {
+	    SDL_GetWindowSize(sdl_window, &info->window_width, &info->window_height);
+
+		if (SDL_Vulkan_GetInstanceExtensions(sdl_window, &info->instance_extensions_count, NULL) == SDL_FALSE) {
+			logprint("main", "nullptr SDL_Vulkan_GetInstanceExtensions failed\n");
+		}
+		info->instance_extensions = ARRAY_MALLOC(const char *, info->instance_extensions_count);
+		if (SDL_Vulkan_GetInstanceExtensions(sdl_window, &info->instance_extensions_count, info->instance_extensions) == SDL_FALSE) {
+			logprint("main", "SDL_Vulkan_GetInstanceExtensions failed\n");
+		}
 	}
 	
 	if (info->validation_layers.enable && !vulkan_check_validation_layer_support(info->validation_layers)) {
@@ -164,21 +236,29 @@ sdl_init_vulkan(Vulkan_Info *info, SDL_Window *sdl_window) {
 	vulkan_create_instance(info);
 	vulkan_setup_debug_messenger(info);
 
-	if (SDL_Vulkan_CreateSurface(sdl_window, info->instance, &info->surface) == SDL_FALSE) {
+	if (!info->headless && SDL_Vulkan_CreateSurface(sdl_window, info->instance, &info->surface) == SDL_FALSE) {
 		logprint("main", "vulkan surface failed being created\n");
 	}
 
 	vulkan_pick_physical_device(info);
 	vulkan_create_logical_device(info);
-	vulkan_create_swap_chain(info);
+	if (info->headless)
+		vulkan_create_offscreen_images(info);
+	else
+		vulkan_create_swap_chain(info);
 	vulkan_create_image_views(info);
 	vulkan_create_render_pass(info);
 	vulkan_create_descriptor_set_layout(info);
+	vulkan_create_pipeline_cache(info);
 
 	Vulkan_Graphics_Pipeline pipeline_info = {};
-	pipeline_info.binding_description.binding = 0;
-	pipeline_info.binding_description.stride = sizeof(Vertex);
-	pipeline_info.binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	pipeline_info.binding_descriptions[0].binding = 0;
+	pipeline_info.binding_descriptions[0].stride = sizeof(Vertex);
+	pipeline_info.binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	pipeline_info.binding_descriptions[1].binding = 1;
+	pipeline_info.binding_descriptions[1].stride = sizeof(Matrix_4x4);
+	pipeline_info.binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 	
 	pipeline_info.attribute_descriptions[0].binding = 0;
 	pipeline_info.attribute_descriptions[0].location = 0;
@@ -194,40 +274,114 @@ sdl_init_vulkan(Vulkan_Info *info, SDL_Window *sdl_window) {
 	pipeline_info.attribute_descriptions[2].location = 2;
 	pipeline_info.attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
 	pipeline_info.attribute_descriptions[2].offset = offsetof(Vertex, uv);
+
+	// per instance transform: one location for each column
+	for (u32 i = 0; i < 4; i++) {
+		pipeline_info.attribute_descriptions[3 + i].binding = 1;
+		pipeline_info.attribute_descriptions[3 + i].location = 3 + i;
+		pipeline_info.attribute_descriptions[3 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		pipeline_info.attribute_descriptions[3 + i].offset = i * sizeof(Vector4);
+	}
     
 	vulkan_create_graphics_pipeline(info, &pipeline_info);
 
 	vulkan_create_command_pool(info);
     vulkan_create_command_buffers(info);
+    vulkan_create_profiler(info);
+	vulkan_create_upload_batches(info);
+	vulkan_init_memory_pools(info);
+	vulkan_create_staging_ring(info);
 	vulkan_create_depth_resources(info);
 	vulkan_create_frame_buffers(info);
 
-	Bitmap yogi = load_bitmap("../assets/bitmaps/yogi.png");
-	vulkan_create_texture_image(info, &yogi);
-	free_bitmap(yogi);
-	vulkan_create_texture_image_view(info);
-	vulkan_create_texture_sampler(info);
-    
-    vulkan_create_buffer(info->device, 
-                         info->physical_device,
-                         1000, 
-                         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                         info->combined_buffer,
-                         info->combined_buffer_memory);
+	vulkan_create_texture_table(info);
     
-
-    info->uniforms_offset[0] = 0;
-    info->uniforms_offset[1] = vulkan_get_alignment(info->uniforms_offset[0] + sizeof(Matrices), 64);
     info->uniform_size = sizeof(Matrices);
+    vulkan_create_uniform_arena(info);
+
+    Matrix_4x4 identity = identity_m4x4();
+    info->identity_instance = vulkan_allocate_buffer_memory(info, sizeof(Matrix_4x4), sizeof(Vector4));
+    vulkan_update_allocation(info, &info->identity_instance, (void*)&identity, sizeof(Matrix_4x4));
     
 	vulkan_create_descriptor_pool(info);
 	vulkan_create_descriptor_sets(info);
 
+	if (info->parallel_recording)
+		vulkan_create_recorder(info);
+
 	vulkan_create_sync_objects(info);
 	vulkan_init_presentation_settings(info);
 }
 
+// loads count meshes and textures twice: once waiting on the gpu after every upload command
+// (how uploads used to work) and once recorded into batches. prints the wall time of both.
+internal void
+sdl_benchmark_uploads(Vulkan_Info *info, u32 count) {
+	const Vertex vertices[4] = {
+        {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+        {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+        {{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+        {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}},
+    };
+    const u32 indices[6] = { 0, 1, 2, 2, 3, 0 };
+
+	// decode once and shrink it so that count textures fit in memory. decoding is not what is measured.
+	Bitmap yogi = load_bitmap("../assets/bitmaps/yogi.png");
+	Bitmap texture = {};
+	texture.width = 128;
+	texture.height = 128;
+	texture.channels = yogi.channels;
+	texture.pitch = texture.width * texture.channels;
+	texture.memory = (u8*)platform_malloc(texture.pitch * texture.height);
+	stbir_resize_uint8(yogi.memory, yogi.width, yogi.height, yogi.pitch, texture.memory, texture.width, texture.height, texture.pitch, texture.channels);
+	free_bitmap(yogi);
+
+	Mesh *meshes = ARRAY_MALLOC(Mesh, count);
+	VkImage *images = ARRAY_MALLOC(VkImage, count);
+	Vulkan_Allocation *images_memory = ARRAY_MALLOC(Vulkan_Allocation, count);
+
+	s64 frequency = SDL_GetPerformanceFrequency();
+	const char *pass_names[2] = { "wait per upload", "batched" };
+
+	for (u32 pass = 0; pass < 2; pass++) {
+		info->upload_immediate = (pass == 0);
+
+		s64 start = SDL_GetPerformanceCounter();
+		for (u32 i = 0; i < count; i++) {
+			Mesh *mesh = &meshes[i];
+			*mesh = {};
+			mesh->vertices_count = ARRAY_COUNT(vertices);
+			mesh->indices_count = ARRAY_COUNT(indices);
+			mesh->vertices = ARRAY_MALLOC(Vertex, mesh->vertices_count);
+			mesh->indices = ARRAY_MALLOC(u32, mesh->indices_count);
+			memcpy(mesh->vertices, vertices, sizeof(vertices));
+			memcpy(mesh->indices, indices, sizeof(indices));
+			render_init_mesh(mesh);
+
+			vulkan_create_texture_image(info, &texture, VK_FORMAT_R8G8B8A8_SRGB, false, images[i], images_memory[i]);
+		}
+		vulkan_wait_uploads(info);
+		s64 end = SDL_GetPerformanceCounter();
+
+		print("upload benchmark (%s): %u meshes + %u textures in %f ms\n", pass_names[pass], count, count, get_seconds_elapsed(frequency, start, end) * 1000.0);
+
+		for (u32 i = 0; i < count; i++) {
+			free_mesh(&meshes[i]);
+			vkDestroyImage(info->device, images[i], nullptr);
+			vulkan_memory_free(&images_memory[i]);
+		}
+		// no frame is running yet so the mesh memory can be given back right away
+		vkDeviceWaitIdle(info->device);
+		vulkan_flush_deletion_queues(info);
+	}
+	info->upload_immediate = false;
+
+	platform_free(meshes);
+	platform_free(images);
+	platform_free(images_memory);
+	platform_free(texture.memory);
+}
+
 internal void
 update_window(u32 width, u32 height, bool8 minimized) {
 	vulkan_info.minimized = minimized;
@@ -241,13 +395,80 @@ update_window(u32 width, u32 height, bool8 minimized) {
 
 #endif // OPENGL / VULKAN
 
+// decodes count bitmaps on the calling thread, then through the loader's work queue and
+// then loads the cooked version on the calling thread. prints the wall time of each. nothing is uploaded.
+internal void
+sdl_benchmark_decode(Bitmap_Loader *loader, u32 count) {
+	const char *filepath = "../assets/bitmaps/yogi.png";
+	s64 frequency = SDL_GetPerformanceFrequency();
+
+	s64 start = SDL_GetPerformanceCounter();
+	for (u32 i = 0; i < count; i++) {
+		Bitmap bitmap = load_bitmap(filepath);
+		free_bitmap(bitmap);
+	}
+	s64 end = SDL_GetPerformanceCounter();
+	print("decode benchmark (1 thread): %u bitmaps in %f ms\n", count, get_seconds_elapsed(frequency, start, end) * 1000.0);
+
+	bool8 use_cache = loader->use_cache;
+	loader->use_cache = false;
+	start = SDL_GetPerformanceCounter();
+	u32 added = 0;
+	u32 received = 0;
+	while (received < count) {
+		while (added < count && bitmap_loader_add(loader, filepath, true, 0))
+			added++;
+
+		Bitmap_Load load;
+		if (bitmap_loader_receive(loader, &load)) {
+			free_bitmap(load.bitmap);
+			received++;
+		} else {
+			work_queue_do_next_entry(loader->work_queue, loader->work_queue->threads_count); // help instead of spinning
+		}
+	}
+	end = SDL_GetPerformanceCounter();
+	print("decode benchmark (%u threads): %u bitmaps in %f ms\n", loader->work_queue->threads_count + 1, count, get_seconds_elapsed(frequency, start, end) * 1000.0);
+	loader->use_cache = use_cache;
+
+	free_bitmap(load_bitmap_cached(filepath, true)); // cooks it if it is not up to date
+	start = SDL_GetPerformanceCounter();
+	for (u32 i = 0; i < count; i++) {
+		Bitmap bitmap = load_bitmap_cached(filepath, true);
+		free_bitmap(bitmap);
+	}
+	end = SDL_GetPerformanceCounter();
+	print("decode benchmark (cooked, 1 thread): %u bitmaps in %f ms\n", count, get_seconds_elapsed(frequency, start, end) * 1000.0);
+}
+
 internal bool8
 sdl_process_input() {
+	TRACE_FUNCTION();
 	SDL_Event event;
 	while(SDL_PollEvent(&event)) {
 		switch(event.type) {
 			case SDL_QUIT: return true;
 
+			case SDL_KEYDOWN: {
+				if (event.key.repeat)
+					break;
+				if (event.key.keysym.sym == SDLK_F9)
+					trace_request_dump();
+#ifdef VULKAN
+				// cycles through the present modes
+				if (event.key.keysym.sym == SDLK_F8) {
+					u32 mode_index = 0;
+					for (u32 i = 0; i < ARRAY_COUNT(vulkan_present_mode_names); i++) {
+						if (vulkan_present_mode_names[i].key == (u32)vulkan_info.present_mode)
+							mode_index = i;
+					}
+					mode_index = (mode_index + 1) % ARRAY_COUNT(vulkan_present_mode_names);
+					vulkan_set_present_mode(&vulkan_info, (VkPresentModeKHR)vulkan_present_mode_names[mode_index].key);
+					print("present mode: %s\n", vulkan_present_mode_names[mode_index].value);
+				}
+#endif // VULKAN
+			} break;
+
 			case SDL_WINDOWEVENT:{
                 SDL_WindowEvent *window_event = &event.window;
                 bool8 minimized = false;	
@@ -303,7 +524,56 @@ int main(int argc, char *argv[]) {
     app.time.start_ticks = SDL_GetPerformanceCounter();
     app.time.last_frame_ticks = app.time.start_ticks;
 
+	// -headless <frames>: render that many frames offscreen, then print a checksum of the last one
+	bool8 headless = false;
+	u32 headless_frames = 0;
+#ifdef VULKAN
+	for (s32 i = 1; i < argc; i++) {
+		if (equal(argv[i], "-headless")) {
+			headless = true;
+			headless_frames = 100;
+			if (i + 1 < argc && is_ascii_digit(argv[i + 1][0]))
+				char_array_to_u32(argv[++i], &headless_frames);
+		}
+	}
+#endif // VULKAN
+
+	// -benchmark <frames>: run the scripted scene for that many frames and write the frame times as json
+	bool8 benchmarking = false;
+	Benchmark bench = {};
+	for (s32 i = 1; i < argc; i++) {
+		if (equal(argv[i], "-benchmark")) {
+			u32 frames = 1000;
+			if (i + 1 < argc && is_ascii_digit(argv[i + 1][0]))
+				char_array_to_u32(argv[++i], &frames);
+			benchmark_init(&bench, frames);
+			benchmarking = true;
+		} else if (equal(argv[i], "-benchmark_output") && i + 1 < argc) {
+			bench.output_filepath = argv[++i];
+		}
+	}
+
+	// -trace [path]: record cpu zones and write them at exit (F9 writes them right away)
+	for (s32 i = 1; i < argc; i++) {
+		if (equal(argv[i], "-trace")) {
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				trace_state.output_filepath = argv[++i];
+			trace_init();
+		}
+	}
+
+	// assets.pack is made by packer.exe. -no_pack loads every file from disk
+	bool8 use_pack = true;
+	for (s32 i = 1; i < argc; i++) {
+		if (equal(argv[i], "-no_pack"))
+			use_pack = false;
+	}
+	if (use_pack && mount_pack("assets.pack"))
+		print("mounted assets.pack\n");
+
 	u32 sdl_init_flags = SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_AUDIO;
+	if (headless)
+		sdl_init_flags = 0; // no display needed
     if (SDL_Init(sdl_init_flags)) {
     	print(SDL_GetError());
     	return 1;
@@ -317,31 +587,116 @@ int main(int argc, char *argv[]) {
 	sdl_window_flags = sdl_window_flags | SDL_WINDOW_VULKAN;
 #endif // OPENGL / VULKAN
 
-    SDL_Window *sdl_window = SDL_CreateWindow("vulkan_basic", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 900, 800, sdl_window_flags);
-    if (sdl_window == NULL) {
-    	print(SDL_GetError());
-    	return 1;
+    s32 window_width = 900;
+    s32 window_height = 800;
+    SDL_Window *sdl_window = NULL;
+    if (!headless) {
+        sdl_window = SDL_CreateWindow("vulkan_basic", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, sdl_window_flags);
+        if (sdl_window == NULL) {
+        	print(SDL_GetError());
+        	return 1;
+        }
+        SDL_GetWindowSize(sdl_window, &window_width, &window_height);
     }
-
-    s32 window_width;
-    s32 window_height;
-    SDL_GetWindowSize(sdl_window, &window_width, &window_height);
 	
 #ifdef OPENGL
 	sdl_init_opengl(sdl_window);
 #elif VULKAN
+    // record the draws of a frame on worker threads
+    Work_Queue work_queue = {};
+    for (s32 i = 1; i < argc; i++) {
+        if (equal(argv[i], "-parallel_record")) {
+            s32 threads_count = SDL_GetCPUCount() - 1;
+            if (threads_count > VULKAN_MAX_RECORDING_JOBS - 1) threads_count = VULKAN_MAX_RECORDING_JOBS - 1;
+            if (threads_count < 0)                              threads_count = 0;
+            work_queue_init(&work_queue, threads_count);
+            vulkan_info.parallel_recording = true;
+            vulkan_info.recorder.work_queue = &work_queue;
+        }
+    }
+
+    // frame pacing
+    for (s32 i = 1; i < argc; i++) {
+        if (equal(argv[i], "-frames_in_flight") && i + 1 < argc) {
+            u32 frames_in_flight = 2;
+            char_array_to_u32(argv[++i], &frames_in_flight);
+            if (frames_in_flight < 1)                           frames_in_flight = 1;
+            if (frames_in_flight > VULKAN_MAX_FRAMES_IN_FLIGHT) frames_in_flight = VULKAN_MAX_FRAMES_IN_FLIGHT;
+            vulkan_info.frames_in_flight = frames_in_flight;
+        } else if (equal(argv[i], "-present_mode") && i + 1 < argc) {
+            u32 mode = pair_get_key(vulkan_present_mode_names, ARRAY_COUNT(vulkan_present_mode_names), argv[++i]);
+            if (mode == ARRAY_COUNT(vulkan_present_mode_names))
+                logprint("main()", "unknown present mode %s (immediate, mailbox, fifo, fifo_relaxed)\n", argv[i]);
+            else
+                vulkan_info.present_mode = (VkPresentModeKHR)mode;
+        } else if (equal(argv[i], "-low_latency")) {
+            vulkan_info.low_latency = true;
+        } else if (equal(argv[i], "-no_bindless")) {
+            vulkan_info.bindless = false; // one descriptor set per texture
+        }
+    }
+
+    vulkan_info.headless = headless;
+    vulkan_info.window_width = window_width;
+    vulkan_info.window_height = window_height;
     sdl_init_vulkan(&vulkan_info, sdl_window);
 
-    Bitmap yogi = load_bitmap("../assets/bitmaps/yogi.png");
-    opengl_init_bitmap_handle(&yogi, TEXTURE_PARAMETERS_DEFAULT);
-    //free_bitmap(yogi);
+    for (s32 i = 1; i < argc; i++) {
+        if (equal(argv[i], "-bench_upload")) {
+            sdl_benchmark_uploads(&vulkan_info, 500);
+        }
+    }
+
 #endif
 
+    // decode bitmaps on worker threads. they get uploaded here as they finish
+    Work_Queue decode_queue = {};
+    s32 decode_threads_count = SDL_GetCPUCount() - 1;
+    if (decode_threads_count < 1) decode_threads_count = 1;
+    work_queue_init(&decode_queue, decode_threads_count);
+    Bitmap_Loader *bitmap_loader = (Bitmap_Loader*)platform_malloc(sizeof(Bitmap_Loader));
+    bitmap_loader_init(bitmap_loader, &decode_queue);
+    bitmap_loader->use_cache = true;
+    bitmap_loader->texture_formats = render_texture_formats();
+    for (s32 i = 1; i < argc; i++) {
+        if (equal(argv[i], "-no_texture_cache"))
+            bitmap_loader->use_cache = false; // always decode the source
+        else if (equal(argv[i], "-no_texture_compression"))
+            bitmap_loader->texture_formats = TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_PIXELS);
+    }
+
+    for (s32 i = 1; i < argc; i++) {
+        if (equal(argv[i], "-bench_decode")) {
+            u32 count = 2000;
+            if (i + 1 < argc && is_ascii_digit(argv[i + 1][0]))
+                char_array_to_u32(argv[++i], &count);
+            sdl_benchmark_decode(bitmap_loader, count);
+        }
+    }
+
+    Bitmap yogi = {};
+    bitmap_loader_add(bitmap_loader, "../assets/bitmaps/yogi.png", true, &yogi);
+    while (bitmap_loader_in_flight(bitmap_loader)) {
+        Bitmap_Load load;
+        if (!bitmap_loader_receive(bitmap_loader, &load)) {
+            work_queue_do_next_entry(&decode_queue, decode_queue.threads_count);
+            continue;
+        }
+
+        // the gpu has its own copy after render_init_bitmap()
+        Bitmap *bitmap = (Bitmap*)load.user_data;
+        *bitmap = load.bitmap;
+        render_init_bitmap(bitmap, TEXTURE_PARAMETERS_DEFAULT);
+        free_bitmap(*bitmap);
+        bitmap->memory = 0;
+        bitmap->file = {};
+    }
+    render_bind_bitmap(&yogi);
+
     Matrices ubo = {};
     ubo.model = create_transform_m4x4({ 0.0f, 0.0f, 0.0f }, get_rotation(0.0f, {0, 0, 1}), {1.0f, 1.0f, 1.0f});
     ubo.view = look_at({ 2.0f, 2.0f, 2.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
     ubo.projection = perspective_projection(45.0f, (float32)window_width / (float32)window_height, 0.1f, 10.0f);
-    render_update_uniform_buffer_object(matrices_ubo, ubo);
     
 	render_clear_color({ 0.0f, 0.2f, 0.4f, 1.0f });
 
@@ -371,34 +726,116 @@ int main(int argc, char *argv[]) {
 	memcpy(mesh.vertices, vertices, sizeof(vertices));
 	memcpy(mesh.indices, indices, sizeof(indices));
 	render_init_mesh(&mesh);
-    
+
+	// benchmark scene: a grid of instances around the test mesh. everything
+	// moves by frame number, not time, so every run renders the same frames.
+	const u32 grid_size = 16;
+	Matrix_4x4 *grid_transforms = 0;
+	if (benchmarking) {
+		grid_transforms = ARRAY_MALLOC(Matrix_4x4, grid_size * grid_size);
+		for (u32 y = 0; y < grid_size; y++) {
+			for (u32 x = 0; x < grid_size; x++) {
+				Vector3 position = { ((float32)x - grid_size * 0.5f) * 0.25f, ((float32)y - grid_size * 0.5f) * 0.25f, -1.0f };
+				grid_transforms[y * grid_size + x] = create_transform_m4x4(position, get_rotation(0.0f, {0, 0, 1}), {0.2f, 0.2f, 0.2f});
+			}
+		}
+	}
+
+	// last frame limits the run. 0 = until the window is closed.
+	u32 frames_limit = headless ? headless_frames : 0;
+	if (benchmarking && (frames_limit == 0 || bench.frames_count < frames_limit))
+		frames_limit = bench.frames_count;
+
+    app.time.last_frame_ticks = SDL_GetPerformanceCounter(); // so the first frame does not include the loading
+    u32 frames_count = 0;
     while(1) {
-    	if (sdl_process_input())
+    	TRACE_ZONE("frame");
+#ifdef VULKAN
+    	if (vulkan_info.low_latency)
+    		vulkan_wait_for_frame();
+#endif // VULKAN
+    	if (!headless && sdl_process_input())
+    		break;
+    	if (frames_limit && frames_count == frames_limit)
     		break;
+#ifdef VULKAN
+    	if (headless && frames_count + 1 == frames_limit)
+    		vulkan_info.headless_target.readback_requested = true;
+#endif // VULKAN
 
 		sdl_update_time(&app.time);
-		if (app.time.new_avg)
+		if (frames_count > 0 && benchmarking)
+			benchmark_record(&bench, app.time.frame_time_s * 1000.0f, render_gpu_frame_time());
+		else if (app.time.new_avg) {
 			print("fps: %f\n", app.time.avg);
+#ifdef VULKAN
+			vulkan_profiler_print(&vulkan_info);
+#endif // VULKAN
+		}
+
+		if (benchmarking) {
+			float32 angle = (float32)frames_count * (2.0f * PI / 240.0f);
+			ubo.model = create_transform_m4x4({ 0.0f, 0.0f, 0.0f }, get_rotation(angle, {0, 0, 1}), {1.0f, 1.0f, 1.0f});
+		}
+    	frames_count++;
 
         render_start_frame();
 #if OPENGL		 				
 		use_shader(&shader);
-#elif VULKAN
-        // Bind Uniform Buffer and Texture
-        vkCmdBindDescriptorSets(vulkan_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 0, 1, &vulkan_info.descriptor_sets[vulkan_info.current_frame], 0, nullptr);
-#endif // OPENGL / VULKAN
-        render_draw_mesh(&mesh);
+#endif // OPENGL
+        {
+            TRACE_ZONE("record");
+            // vulkan: every update gets its own slice of the frame's uniform memory
+            render_update_uniform_buffer_object(matrices_ubo, ubo);
+            render_gpu_marker_begin("mesh");
+            render_draw_mesh(&mesh);
+            render_gpu_marker_end();
+            if (benchmarking) {
+                render_gpu_marker_begin("grid");
+                render_draw_mesh_instanced(&mesh, grid_transforms, grid_size * grid_size);
+                render_gpu_marker_end();
+            }
+        }
         render_end_frame();
+        trace_frame_end();
     }
 
-#ifdef OPENGL
+    if (benchmarking) {
+        // the time of the last frame is only known after it
+        sdl_update_time(&app.time);
+        benchmark_record(&bench, app.time.frame_time_s * 1000.0f, render_gpu_frame_time());
+        benchmark_write_json(&bench);
+        benchmark_destroy(&bench);
+        platform_free(grid_transforms);
+    }
 
+#ifdef OPENGL
+    render_free_bitmap(&yogi);
 #elif VULKAN
+    if (headless) {
+        u64 checksum = vulkan_readback_checksum(&vulkan_info);
+        // stdout and not print(): scripts compare the checksum and print() only goes to the debugger on windows
+        fprintf(stdout, "headless: %u frames, checksum %016llx\n", frames_count, (unsigned long long)checksum);
+    }
+
+    render_free_bitmap(&yogi);
     vkDeviceWaitIdle(vulkan_info.device);
     vulkan_cleanup(&vulkan_info);
+    if (vulkan_info.parallel_recording)
+        work_queue_destroy(&work_queue);
 #endif
 
-    SDL_DestroyWindow(sdl_window);
+    work_queue_destroy(&decode_queue);
+    platform_free(bitmap_loader);
+    unmount_pack();
+
+    if (trace_state.enabled) {
+        trace_write_json(trace_state.output_filepath);
+        trace_destroy();
+    }
+
+    if (sdl_window != NULL)
+        SDL_DestroyWindow(sdl_window);
 
 	return 0;
 }
@@ -0,0 +1,202 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+//
+// Trace
+//
+
+// scoped cpu zones written to a buffer per thread. only the owning thread writes
+// to its buffer, so recording takes no locks. trace_write_json() writes the
+// chrome://tracing / Perfetto json format. dump between frames: a buffer that
+// is written while it is dumped can show a torn oldest event.
+
+#define TRACE_MAX_THREADS           32
+#define TRACE_EVENTS_PER_THREAD     65536 // ring, the oldest events get overwritten
+
+struct Trace_Event {
+	const char *name; // has to stay valid until the dump (string literals)
+	s64 start_ticks;
+	s64 end_ticks;
+};
+
+struct Trace_Buffer {
+	u32 thread_id;
+	SDL_atomic_t events_count; // total written. index in events is events_count % TRACE_EVENTS_PER_THREAD
+	Trace_Event events[TRACE_EVENTS_PER_THREAD];
+};
+
+struct Trace {
+	bool8 enabled;
+	bool8 dump_requested;
+	const char *output_filepath = "trace.json";
+
+	s64 performance_frequency;
+	s64 start_ticks;
+
+	SDL_atomic_t buffers_count;
+	Trace_Buffer *buffers[TRACE_MAX_THREADS];
+};
+
+global Trace trace_state;
+thread_local Trace_Buffer *trace_thread_buffer;
+
+// the first zone on a thread registers its buffer
+internal Trace_Buffer*
+trace_get_thread_buffer() {
+	if (trace_thread_buffer != 0)
+		return trace_thread_buffer;
+
+	s32 index = SDL_AtomicAdd(&trace_state.buffers_count, 1);
+	if (index >= TRACE_MAX_THREADS) {
+		SDL_AtomicAdd(&trace_state.buffers_count, -1);
+		return 0;
+	}
+
+	Trace_Buffer *buffer = (Trace_Buffer*)platform_malloc(sizeof(Trace_Buffer));
+	platform_memory_set(buffer, 0, sizeof(Trace_Buffer));
+	buffer->thread_id = (u32)SDL_ThreadID();
+
+	SDL_MemoryBarrierRelease();
+	trace_state.buffers[index] = buffer;
+	trace_thread_buffer = buffer;
+	return buffer;
+}
+
+internal void
+trace_init() {
+	trace_state.performance_frequency = SDL_GetPerformanceFrequency();
+	trace_state.start_ticks = SDL_GetPerformanceCounter();
+	trace_state.enabled = true;
+	trace_get_thread_buffer(); // the calling thread is the main thread (buffer 0)
+}
+
+inline void
+trace_add_event(const char *name, s64 start_ticks, s64 end_ticks) {
+	Trace_Buffer *buffer = trace_get_thread_buffer();
+	if (buffer == 0)
+		return;
+
+	u32 count = (u32)SDL_AtomicGet(&buffer->events_count);
+	Trace_Event *event = &buffer->events[count % TRACE_EVENTS_PER_THREAD];
+	event->name = name;
+	event->start_ticks = start_ticks;
+	event->end_ticks = end_ticks;
+
+	SDL_MemoryBarrierRelease(); // event has to be written before it is counted
+	SDL_AtomicSet(&buffer->events_count, (s32)(count + 1));
+}
+
+// records the time from construction to the end of the scope
+struct Trace_Zone {
+	const char *name;
+	s64 start_ticks;
+
+	Trace_Zone(const char *in_name) {
+		name = in_name;
+		start_ticks = trace_state.enabled ? SDL_GetPerformanceCounter() : 0;
+	}
+
+	~Trace_Zone() {
+		if (trace_state.enabled && start_ticks != 0)
+			trace_add_event(name, start_ticks, SDL_GetPerformanceCounter());
+	}
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name)    Trace_Zone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_FUNCTION()    TRACE_ZONE(__FUNCTION__)
+
+inline float64
+trace_ticks_to_us(s64 ticks) {
+	return (float64)(ticks - trace_state.start_ticks) * 1000000.0 / (float64)trace_state.performance_frequency;
+}
+
+internal bool8
+trace_write_json(const char *filepath) {
+	s32 buffers_count = SDL_AtomicGet(&trace_state.buffers_count);
+	if (buffers_count > TRACE_MAX_THREADS)
+		buffers_count = TRACE_MAX_THREADS;
+	SDL_MemoryBarrierAcquire();
+
+	u32 events_total = 0;
+	for (s32 i = 0; i < buffers_count; i++) {
+		if (trace_state.buffers[i] == 0)
+			continue; // thread is registering right now
+		u32 count = (u32)SDL_AtomicGet(&trace_state.buffers[i]->events_count);
+		events_total += (count < TRACE_EVENTS_PER_THREAD) ? count : TRACE_EVENTS_PER_THREAD;
+	}
+
+	u32 buffer_size = 256 + (events_total + buffers_count) * 160;
+	char *json = (char*)platform_malloc(buffer_size);
+	u32 length = 0;
+
+	char_array_appendf(json, buffer_size, &length, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool8 first = true;
+	for (s32 i = 0; i < buffers_count; i++) {
+		Trace_Buffer *buffer = trace_state.buffers[i];
+		if (buffer == 0)
+			continue;
+
+		char_array_appendf(json, buffer_size, &length, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %d\"}}",
+						   first ? "" : ",\n", buffer->thread_id, i == 0 ? "main" : "worker", i);
+		first = false;
+
+		u32 count = (u32)SDL_AtomicGet(&buffer->events_count);
+		SDL_MemoryBarrierAcquire();
+		u32 first_event = (count > TRACE_EVENTS_PER_THREAD) ? count - TRACE_EVENTS_PER_THREAD : 0;
+		for (u32 event_index = first_event; event_index < count; event_index++) {
+			Trace_Event *event = &buffer->events[event_index % TRACE_EVENTS_PER_THREAD];
+			float64 ts = trace_ticks_to_us(event->start_ticks);
+			float64 dur = trace_ticks_to_us(event->end_ticks) - ts;
+			char_array_appendf(json, buffer_size, &length, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+							   event->name, buffer->thread_id, ts, dur);
+		}
+	}
+	char_array_appendf(json, buffer_size, &length, "\n]}\n");
+
+	if (length >= buffer_size) {
+		logprint("trace_write_json()", "trace was truncated\n");
+		platform_free(json);
+		return false;
+	}
+
+	bool8 result = save_file(filepath, json, length);
+	if (result)
+		print("trace: wrote %u events to %s\n", events_total, filepath);
+	else
+		logprint("trace_write_json()", "failed to write %s\n", filepath);
+
+	platform_free(json);
+	return result;
+}
+
+// the dump happens in trace_frame_end() so it does not land in the middle of a frame
+inline void
+trace_request_dump() {
+	trace_state.dump_requested = true;
+}
+
+inline void
+trace_frame_end() {
+	if (trace_state.enabled && trace_state.dump_requested) {
+		trace_state.dump_requested = false;
+		trace_write_json(trace_state.output_filepath);
+	}
+}
+
+// frees the buffers. threads that traced must not trace anymore.
+internal void
+trace_destroy() {
+	trace_state.enabled = false;
+	s32 buffers_count = SDL_AtomicGet(&trace_state.buffers_count);
+	for (s32 i = 0; i < buffers_count && i < TRACE_MAX_THREADS; i++) {
+		if (trace_state.buffers[i] != 0)
+			platform_free(trace_state.buffers[i]);
+		trace_state.buffers[i] = 0;
+	}
+	SDL_AtomicSet(&trace_state.buffers_count, 0);
+	trace_thread_buffer = 0;
+}
+
+#endif // TRACE_H
@@ -84,7 +84,7 @@ vulkan_create_instance(Vulkan_Info *vulkan_info) {
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "No Engine";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+    app_info.apiVersion = VK_API_VERSION_1_2; // devices below it still work, without bindless textures
 
     VkInstanceCreateInfo create_info = {};
 	create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -114,7 +114,7 @@ vulkan_create_instance(Vulkan_Info *vulkan_info) {
 
 internal Vulkan_Queue_Family_Indices
 vulkan_find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface) {
-	Vulkan_Queue_Family_Indices indices;
+	Vulkan_Queue_Family_Indices indices = {};
 
 	u32 queue_family_count = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
@@ -129,11 +129,30 @@ vulkan_find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface) {
 		}
 
 		VkBool32 present_support = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, queue_index, surface, &present_support);
+		if (surface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, queue_index, surface, &present_support);
 		if (present_support) {
 			indices.present_family_found = true;
 			indices.present_family = queue_index;
 		}
+
+		// prefer a transfer only family (no compute either) over one that also does compute
+		VkQueueFlags flags = queue_families[queue_index].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			if (!indices.transfer_family_found || !(flags & VK_QUEUE_COMPUTE_BIT)) {
+				indices.transfer_family_found = true;
+				indices.transfer_family = queue_index;
+			}
+		}
+	}
+
+	if (!indices.transfer_family_found)
+		indices.transfer_family = indices.graphics_family;
+
+	// headless: nothing is presented
+	if (surface == VK_NULL_HANDLE) {
+		indices.present_family_found = indices.graphics_family_found;
+		indices.present_family = indices.graphics_family;
 	}
 
 	platform_free(queue_families);
@@ -184,7 +203,7 @@ vulkan_query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR surface) {
 	vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &details.present_modes_count, nullptr);
 	if (details.present_modes_count != 0) {
 		details.present_modes = ARRAY_MALLOC(VkPresentModeKHR, details.present_modes_count);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &details.present_modes_count, nullptr);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &details.present_modes_count, details.present_modes);
 	}
 
 	return details;
@@ -204,18 +223,16 @@ vulkan_is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR surface, const c
 	Vulkan_Queue_Family_Indices indices = vulkan_find_queue_families(device, surface);
 
 	bool8 extensions_supported = vulkan_check_device_extension_support(device, device_extensions, device_extensions_count);
-	bool8 swap_chain_adequate = false;
-	if (extensions_supported) {
+	bool8 swap_chain_adequate = (surface == VK_NULL_HANDLE); // headless does not need one
+	if (extensions_supported && surface != VK_NULL_HANDLE) {
 		Vulkan_Swap_Chain_Support_Details swap_chain_support = vulkan_query_swap_chain_support(device, surface);
 		swap_chain_adequate = swap_chain_support.formats_count && swap_chain_support.present_modes_count;
 		platform_free(swap_chain_support.formats);
 		platform_free(swap_chain_support.present_modes);
 	}
 
-	VkPhysicalDeviceFeatures supported_features;
-	vkGetPhysicalDeviceFeatures(device, &supported_features);
-
-	return indices.graphics_family_found && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy;
+	// samplerAnisotropy is used if it is there (software rasterizers may not have it)
+	return indices.graphics_family_found && extensions_supported && swap_chain_adequate;
 }
 
 internal void
@@ -232,7 +249,8 @@ vulkan_pick_physical_device(Vulkan_Info *info) {
 	vkEnumeratePhysicalDevices(info->instance, &device_count, devices);
 
 	for (u32 device_index = 0; device_index < device_count; device_index++) {
-		if (vulkan_is_device_suitable(devices[device_index], info->surface, info->device_extensions, ARRAY_COUNT(info->device_extensions))) {
+		u32 device_extensions_count = info->headless ? 0 : ARRAY_COUNT(info->device_extensions);
+		if (vulkan_is_device_suitable(devices[device_index], info->surface, info->device_extensions, device_extensions_count)) {
 			info->physical_device = devices[device_index];
 			break;
 		}
@@ -249,12 +267,24 @@ internal void
 vulkan_create_logical_device(Vulkan_Info *info) {
 	Vulkan_Queue_Family_Indices indices = vulkan_find_queue_families(info->physical_device, info->surface);
 
-	// Specify the device queues we want
-	VkDeviceQueueCreateInfo *queue_create_infos = ARRAY_MALLOC(VkDeviceQueueCreateInfo, indices.unique_families);
-	u32 unique_queue_families[indices.unique_families] = { indices.graphics_family, indices.present_family };
+	// Specify the device queues we want (one per unique family)
+	u32 unique_queue_families[Vulkan_Queue_Family_Indices::max_unique_families];
+	u32 unique_families_count = 0;
+	u32 wanted_families[Vulkan_Queue_Family_Indices::max_unique_families] = { indices.graphics_family, indices.present_family, indices.transfer_family };
+	for (u32 wanted_index = 0; wanted_index < Vulkan_Queue_Family_Indices::max_unique_families; wanted_index++) {
+		bool8 found = false;
+		for (u32 unique_index = 0; unique_index < unique_families_count; unique_index++) {
+			if (unique_queue_families[unique_index] == wanted_families[wanted_index])
+				found = true;
+		}
+		if (!found)
+			unique_queue_families[unique_families_count++] = wanted_families[wanted_index];
+	}
+
+	VkDeviceQueueCreateInfo *queue_create_infos = ARRAY_MALLOC(VkDeviceQueueCreateInfo, unique_families_count);
 
 	float32 queue_priority = 1.0f;
-	for (u32 queue_index = 0; queue_index < indices.unique_families; queue_index++) {
+	for (u32 queue_index = 0; queue_index < unique_families_count; queue_index++) {
 		VkDeviceQueueCreateInfo queue_create_info = {};
 	    queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 	    queue_create_info.queueFamilyIndex = unique_queue_families[queue_index];
@@ -264,17 +294,83 @@ vulkan_create_logical_device(Vulkan_Info *info) {
 	}
 
 	// Features requested
+	VkPhysicalDeviceFeatures supported_features = {};
+	vkGetPhysicalDeviceFeatures(info->physical_device, &supported_features);
+
 	VkPhysicalDeviceFeatures device_features = {};
-	device_features.samplerAnisotropy = VK_TRUE;
+	info->sampler_anisotropy = supported_features.samplerAnisotropy;
+	device_features.samplerAnisotropy = supported_features.samplerAnisotropy;
+
+	// cooked textures can be block compressed if this is there
+	info->texture_compression_bc = supported_features.textureCompressionBC;
+	device_features.textureCompressionBC = supported_features.textureCompressionBC;
+
+	// the draw list issues every draw of a buffer with one indirect call if these are there
+	info->multi_draw_indirect = supported_features.multiDrawIndirect && supported_features.drawIndirectFirstInstance;
+	if (info->multi_draw_indirect) {
+		device_features.multiDrawIndirect = VK_TRUE;
+		device_features.drawIndirectFirstInstance = VK_TRUE;
+	}
+
+	// bindless textures need descriptor indexing (core in 1.2)
+	VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {};
+	indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	if (info->bindless) {
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+		info->bindless = false;
+		if (properties.apiVersion >= VK_API_VERSION_1_2) {
+			VkPhysicalDeviceDescriptorIndexingFeatures supported_indexing = {};
+			supported_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+			VkPhysicalDeviceFeatures2 features2 = {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &supported_indexing;
+			vkGetPhysicalDeviceFeatures2(info->physical_device, &features2);
+
+			info->bindless = supported_indexing.runtimeDescriptorArray &&
+			                 supported_indexing.descriptorBindingPartiallyBound &&
+			                 supported_indexing.descriptorBindingSampledImageUpdateAfterBind &&
+			                 supported_indexing.descriptorBindingUpdateUnusedWhilePending;
+		}
+
+		if (info->bindless) {
+			indexing_features.runtimeDescriptorArray = VK_TRUE;
+			indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+			indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+			VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = {};
+			indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties2.pNext = &indexing_properties;
+			vkGetPhysicalDeviceProperties2(info->physical_device, &properties2);
+
+			u32 capacity = VULKAN_MAX_BINDLESS_TEXTURES;
+			u32 limits[4] = {
+				indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+				indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+				indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+				indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+			};
+			for (u32 i = 0; i < ARRAY_COUNT(limits); i++) {
+				if (limits[i] < capacity)
+					capacity = limits[i];
+			}
+			info->textures.bindless_capacity = capacity;
+		}
+	}
 
 	// Set up device
 	VkDeviceCreateInfo create_info = {};
 	create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	create_info.pNext = info->bindless ? &indexing_features : nullptr;
 	create_info.pQueueCreateInfos = queue_create_infos;
-	create_info.queueCreateInfoCount = indices.unique_families;
+	create_info.queueCreateInfoCount = unique_families_count;
 	create_info.pEnabledFeatures = &device_features;
 
-	create_info.enabledExtensionCount = ARRAY_COUNT(info->device_extensions);
+	create_info.enabledExtensionCount = info->headless ? 0 : ARRAY_COUNT(info->device_extensions); // no swap chain
 	create_info.ppEnabledExtensionNames = (const char *const *)info->device_extensions;
 
 	if (info->validation_layers.enable) {
@@ -291,6 +387,10 @@ vulkan_create_logical_device(Vulkan_Info *info) {
 	// Create the queues
 	vkGetDeviceQueue(info->device, indices.graphics_family, 0, &info->graphics_queue);
 	vkGetDeviceQueue(info->device, indices.present_family, 0, &info->present_queue);
+	vkGetDeviceQueue(info->device, indices.transfer_family, 0, &info->transfer_queue);
+
+	info->queue_families = indices;
+	info->dedicated_transfer = indices.transfer_family_found;
 
 	platform_free(queue_create_infos);
 }
@@ -307,11 +407,19 @@ vulkan_choose_swap_surface_format(VkSurfaceFormatKHR *formats, u32 count) {
 }
 
 // VSYNC OFF : VK_PRESENT_MODE_IMMEDIATE_KHR 
-// VSYNC ON  : VK_PRESENT_MODE_MAILBOX_KHR
+// VSYNC ON  : VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR
+// VSYNC ON but tears when late : VK_PRESENT_MODE_FIFO_RELAXED_KHR
+global const Pair vulkan_present_mode_names[4] = {
+	{ VK_PRESENT_MODE_IMMEDIATE_KHR,    "immediate" },
+	{ VK_PRESENT_MODE_MAILBOX_KHR,      "mailbox" },
+	{ VK_PRESENT_MODE_FIFO_KHR,         "fifo" },
+	{ VK_PRESENT_MODE_FIFO_RELAXED_KHR, "fifo_relaxed" },
+};
+
 internal VkPresentModeKHR
-vulkan_choose_swap_present_mode(VkPresentModeKHR *modes, u32 count) {
+vulkan_choose_swap_present_mode(VkPresentModeKHR *modes, u32 count, VkPresentModeKHR preferred) {
 	for (u32 i = 0; i < count; i++) {
-		if (modes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+		if (modes[i] == preferred) {
 			return modes[i];
 		}
 	}
@@ -332,13 +440,20 @@ vulkan_choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities, u32 wind
 	}
 }
 
-internal void
+// returns false if there is nothing to present to (minimized) or the swap chain could not be
+// created. info->swap_chains[0] is only replaced if it worked.
+internal bool8
 vulkan_create_swap_chain(Vulkan_Info *info) {
 	Vulkan_Swap_Chain_Support_Details swap_chain_support = vulkan_query_swap_chain_support(info->physical_device, info->surface);
 
 	VkSurfaceFormatKHR surface_format = vulkan_choose_swap_surface_format(swap_chain_support.formats, swap_chain_support.formats_count);
-	VkPresentModeKHR present_mode = vulkan_choose_swap_present_mode(swap_chain_support.present_modes, swap_chain_support.present_modes_count);
+	VkPresentModeKHR present_mode = vulkan_choose_swap_present_mode(swap_chain_support.present_modes, swap_chain_support.present_modes_count, info->present_mode);
+	if (present_mode != info->present_mode)
+		logprint("vulkan_create_swap_chain()", "present mode not supported, using FIFO\n");
+	info->active_present_mode = present_mode;
 	VkExtent2D extent = vulkan_choose_swap_extent(swap_chain_support.capabilities, info->window_width, info->window_height);
+	if (extent.width == 0 || extent.height == 0)
+		return false;
 
 	u32 image_count = swap_chain_support.capabilities.minImageCount + 1;
 	if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount) {
@@ -369,14 +484,17 @@ vulkan_create_swap_chain(Vulkan_Info *info) {
 	}
 
 	create_info.preTransform = swap_chain_support.capabilities.currentTransform;
+	create_info.oldSwapchain = info->swap_chains[0]; // VK_NULL_HANDLE the first time. lets the driver reuse its resources.
 	create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	create_info.presentMode = present_mode;
 	create_info.clipped = VK_TRUE;
-	create_info.oldSwapchain = VK_NULL_HANDLE;
 
-	if (vkCreateSwapchainKHR(info->device, &create_info, nullptr, &info->swap_chains[0])) {
+	VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
+	if (vkCreateSwapchainKHR(info->device, &create_info, nullptr, &swap_chain) != VK_SUCCESS) {
 		logprint("vulkan_create_swap_chain()", "failed to create swap chain\n");
+		return false;
 	}
+	info->swap_chains[0] = swap_chain;
 	
 	u32 swap_chain_images_count = 0;
 	vkGetSwapchainImagesKHR(info->device, info->swap_chains[0], &swap_chain_images_count, nullptr);
@@ -385,10 +503,11 @@ vulkan_create_swap_chain(Vulkan_Info *info) {
 
 	info->swap_chain_image_format = surface_format.format;
 	info->swap_chain_extent = extent;
+	return true;
 }
 
 internal VkImageView
-vulkan_create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags) {
+vulkan_create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags, u32 mip_levels = 1) {
 	VkImageViewCreateInfo view_info{};
 	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	view_info.image = image;
@@ -396,7 +515,7 @@ vulkan_create_image_view(VkDevice device, VkImage image, VkFormat format, VkImag
 	view_info.format = format;
 	view_info.subresourceRange.aspectMask = aspect_flags;
 	view_info.subresourceRange.baseMipLevel = 0;
-	view_info.subresourceRange.levelCount = 1;
+	view_info.subresourceRange.levelCount = mip_levels;
 	view_info.subresourceRange.baseArrayLayer = 0;
 	view_info.subresourceRange.layerCount = 1;
 
@@ -452,7 +571,7 @@ vulkan_create_render_pass(Vulkan_Info *info) {
 	color_attachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	color_attachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment.finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	color_attachment.finalLayout    = info->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference color_attachment_ref = {};
 	color_attachment_ref.attachment = 0;
@@ -503,6 +622,98 @@ vulkan_create_render_pass(Vulkan_Info *info) {
 	}
 }
 
+//
+// Pipeline Cache
+//
+
+// returns false if the data in file was made by a different device or driver
+internal bool8
+vulkan_pipeline_cache_valid(Vulkan_Info *info, File file) {
+	if (file.memory == 0 || file.size < sizeof(Vulkan_Pipeline_Cache_Header))
+		return false;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+	Vulkan_Pipeline_Cache_Header *header = (Vulkan_Pipeline_Cache_Header*)file.memory;
+	if (header->magic != VULKAN_PIPELINE_CACHE_MAGIC ||
+		header->data_size != file.size - sizeof(Vulkan_Pipeline_Cache_Header) ||
+		header->vendor_id != properties.vendorID ||
+		header->device_id != properties.deviceID ||
+		header->driver_version != properties.driverVersion ||
+		memcmp(header->pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return false;
+
+	// the header vulkan puts at the start of the data has to agree too
+	if (header->data_size < 16 + VK_UUID_SIZE)
+		return false;
+	u32 *data = (u32*)((u8*)file.memory + sizeof(Vulkan_Pipeline_Cache_Header));
+	if (data[0] < 16 + VK_UUID_SIZE ||
+		data[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		data[2] != properties.vendorID ||
+		data[3] != properties.deviceID ||
+		memcmp(&data[4], properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return false;
+
+	return true;
+}
+
+// seeds the cache with the data saved by the last run if it is still valid
+internal void
+vulkan_create_pipeline_cache(Vulkan_Info *info) {
+	File file = map_file(info->pipeline_cache_filepath);
+
+	VkPipelineCacheCreateInfo create_info = {};
+	create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if (vulkan_pipeline_cache_valid(info, file)) {
+		create_info.initialDataSize = file.size - sizeof(Vulkan_Pipeline_Cache_Header);
+		create_info.pInitialData = (u8*)file.memory + sizeof(Vulkan_Pipeline_Cache_Header);
+	} else if (file.memory != 0) {
+		print("pipeline cache %s is out of date\n", info->pipeline_cache_filepath);
+	}
+
+	if (vkCreatePipelineCache(info->device, &create_info, nullptr, &info->pipeline_cache) != VK_SUCCESS) {
+		logprint("vulkan_create_pipeline_cache()", "failed to create pipeline cache\n");
+		info->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	free_file(&file);
+}
+
+internal void
+vulkan_save_pipeline_cache(Vulkan_Info *info) {
+	if (info->pipeline_cache == VK_NULL_HANDLE)
+		return;
+
+	size_t data_size = 0;
+	if (vkGetPipelineCacheData(info->device, info->pipeline_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0) {
+		logprint("vulkan_save_pipeline_cache()", "failed to get pipeline cache size\n");
+		return;
+	}
+
+	u32 file_size = sizeof(Vulkan_Pipeline_Cache_Header) + (u32)data_size;
+	u8 *memory = (u8*)platform_malloc(file_size);
+
+	if (vkGetPipelineCacheData(info->device, info->pipeline_cache, &data_size, memory + sizeof(Vulkan_Pipeline_Cache_Header)) == VK_SUCCESS) {
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+		Vulkan_Pipeline_Cache_Header *header = (Vulkan_Pipeline_Cache_Header*)memory;
+		header->magic = VULKAN_PIPELINE_CACHE_MAGIC;
+		header->data_size = (u32)data_size;
+		header->vendor_id = properties.vendorID;
+		header->device_id = properties.deviceID;
+		header->driver_version = properties.driverVersion;
+		memcpy(header->pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		save_file(info->pipeline_cache_filepath, memory, sizeof(Vulkan_Pipeline_Cache_Header) + (u32)data_size);
+	} else {
+		logprint("vulkan_save_pipeline_cache()", "failed to get pipeline cache data\n");
+	}
+
+	platform_free(memory);
+}
+
 internal VkShaderModule
 vulkan_create_shader_module(VkDevice device, File code) {
 	VkShaderModuleCreateInfo create_info = {};
@@ -518,10 +729,50 @@ vulkan_create_shader_module(VkDevice device, File code) {
 	return shader_module;
 }
 
+// bump when anything that changes the compiled SPIR-V changes (compile options, shaderc version)
+#define VULKAN_SHADER_CACHE_VERSION 1
+
+// returns the SPIR-V of the GLSL at filepath. it is loaded from the shader cache if the
+// source was compiled before. otherwise it is compiled and stored. compiler is initialized
+// the first time it is needed. free the result with free_file().
 internal File
-vulkan_load_shader(shaderc_compiler_t compiler, const char *filepath, shaderc_shader_kind shader_kind) {
-	File file = load_file(filepath);
-	const shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, (char*)file.memory, file.size, shader_kind, get_filename(filepath), "main", nullptr);
+vulkan_load_shader(Vulkan_Info *info, shaderc_compiler_t *compiler, const char *filepath, shaderc_shader_kind shader_kind) {
+	File result_file = {};
+
+	File file = map_file(filepath);
+	if (file.memory == 0)
+		return result_file;
+
+	u32 cache_version = VULKAN_SHADER_CACHE_VERSION;
+	u64 hash = fnv1a_64(file.memory, file.size);
+	hash = fnv1a_64(&shader_kind, sizeof(shader_kind), hash);
+	hash = fnv1a_64(&cache_version, sizeof(cache_version), hash);
+	hash = fnv1a_64(&info->bindless, sizeof(info->bindless), hash); // changes the defines
+
+	char cache_filepath[256];
+	snprintf(cache_filepath, sizeof(cache_filepath), "%s/%016llx.spv", info->shader_cache_path, (unsigned long long)hash);
+
+	FILE *cached = fopen(cache_filepath, "rb");
+	if (cached) {
+		fclose(cached);
+		free_file(&file);
+		result_file = map_file(cache_filepath);
+		result_file.filepath = filepath;
+		return result_file;
+	}
+
+	if (*compiler == 0)
+		*compiler = shaderc_compiler_initialize();
+
+	shaderc_compile_options_t options = shaderc_compile_options_initialize();
+	if (info->bindless)
+		shaderc_compile_options_add_macro_definition(options, "BINDLESS", 8, nullptr, 0);
+
+	const char *filename = get_filename(filepath);
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(*compiler, (char*)file.memory, file.size, shader_kind, filename, "main", options);
+	platform_free((void*)filename);
+	free_file(&file);
+	shaderc_compile_options_release(options);
 
 	u32 num_of_warnings = (u32)shaderc_result_get_num_warnings(result);
 	u32 num_of_errors = (u32)shaderc_result_get_num_errors(result);
@@ -531,26 +782,32 @@ vulkan_load_shader(shaderc_compiler_t compiler, const char *filepath, shaderc_sh
 		logprint("vulkan_load_shader()", "%s", error_message);
 	}
 
-	u32 length = (u32)shaderc_result_get_length(result);
-	const char *bytes = shaderc_result_get_bytes(result);
+	if (shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success) {
+		result_file.size = (u32)shaderc_result_get_length(result);
+		result_file.memory = platform_malloc(result_file.size);
+		result_file.filepath = filepath;
+		platform_memory_copy(result_file.memory, (void*)shaderc_result_get_bytes(result), result_file.size);
 
-	File result_file = {};
-	result_file.memory = (void*)bytes;
-	result_file.size = length;
+		platform_create_directory(info->shader_cache_path);
+		save_file(cache_filepath, result_file.memory, result_file.size);
+	}
+
+	shaderc_result_release(result);
 	return result_file;
 }
 
 internal void
 vulkan_create_graphics_pipeline(Vulkan_Info *info, Vulkan_Graphics_Pipeline *pipeline_info) {
-	shaderc_compiler_t compiler = shaderc_compiler_initialize();
-	File vert = vulkan_load_shader(compiler, "../assets/shaders/basic.vert", shaderc_glsl_vertex_shader);
-	File frag = vulkan_load_shader(compiler, "../assets/shaders/basic.frag", shaderc_glsl_fragment_shader);
-
-	//File vert = load_file("../vert.spv");
-	//File frag = load_file("../frag.spv");
+	shaderc_compiler_t compiler = 0;
+	File vert = vulkan_load_shader(info, &compiler, "../assets/shaders/basic.vert", shaderc_glsl_vertex_shader);
+	File frag = vulkan_load_shader(info, &compiler, "../assets/shaders/basic.frag", shaderc_glsl_fragment_shader);
+	if (compiler != 0)
+		shaderc_compiler_release(compiler);
 
 	VkShaderModule vert_shader_module = vulkan_create_shader_module(info->device, vert);
 	VkShaderModule frag_shader_module = vulkan_create_shader_module(info->device, frag);
+	free_file(&vert);
+	free_file(&frag);
 
 	VkPipelineShaderStageCreateInfo vert_shader_stage_info = {};
 	vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -574,9 +831,9 @@ vulkan_create_graphics_pipeline(Vulkan_Info *info, Vulkan_Graphics_Pipeline *pip
 
 	VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
 	vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertex_input_info.vertexBindingDescriptionCount = 1;
-	vertex_input_info.pVertexBindingDescriptions = &pipeline_info->binding_description;     // Optional
-	vertex_input_info.vertexAttributeDescriptionCount = 3;
+	vertex_input_info.vertexBindingDescriptionCount = ARRAY_COUNT(pipeline_info->binding_descriptions);
+	vertex_input_info.pVertexBindingDescriptions = pipeline_info->binding_descriptions;     // Optional
+	vertex_input_info.vertexAttributeDescriptionCount = ARRAY_COUNT(pipeline_info->attribute_descriptions);
 	vertex_input_info.pVertexAttributeDescriptions = pipeline_info->attribute_descriptions; // Optional
 
 	VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
@@ -644,12 +901,21 @@ vulkan_create_graphics_pipeline(Vulkan_Info *info, Vulkan_Graphics_Pipeline *pip
 	depth_stencil.front = {};                          // Optional
 	depth_stencil.back = {};                           // Optional
 
+	// set 0: uniforms, set 1: the texture of the draw (or all of them bindless)
+	VkDescriptorSetLayout set_layouts[2] = { info->descriptor_set_layout, info->textures.set_layout };
+
+	// bindless: index of the draw's texture
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(u32);
+
 	VkPipelineLayoutCreateInfo pipeline_layout_info = {};
 	pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_info.setLayoutCount         = 1;                            // Optional
-	pipeline_layout_info.pSetLayouts            = &info->descriptor_set_layout; // Optional
-	pipeline_layout_info.pushConstantRangeCount = 0;                            // Optional
-	pipeline_layout_info.pPushConstantRanges    = nullptr;                      // Optional
+	pipeline_layout_info.setLayoutCount         = ARRAY_COUNT(set_layouts);     // Optional
+	pipeline_layout_info.pSetLayouts            = set_layouts;                  // Optional
+	pipeline_layout_info.pushConstantRangeCount = info->bindless ? 1 : 0;       // Optional
+	pipeline_layout_info.pPushConstantRanges    = &push_constant_range;         // Optional
 	
 	if (vkCreatePipelineLayout(info->device, &pipeline_layout_info, nullptr, &info->pipeline_layout) != VK_SUCCESS) {
 		logprint("vulkan_create_graphics_pipeline()", "failed to create pipeline layout\n");
@@ -673,7 +939,7 @@ vulkan_create_graphics_pipeline(Vulkan_Info *info, Vulkan_Graphics_Pipeline *pip
 	pipeline_create_info.basePipelineHandle  = VK_NULL_HANDLE;        // Optional
 	pipeline_create_info.basePipelineIndex   = -1;                    // Optional
 
-	if (vkCreateGraphicsPipelines(info->device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &info->graphics_pipeline) != VK_SUCCESS) {
+	if (vkCreateGraphicsPipelines(info->device, info->pipeline_cache, 1, &pipeline_create_info, nullptr, &info->graphics_pipeline) != VK_SUCCESS) {
 		logprint("vulkan_create_graphics_pipeline()", "failed to create graphics pipelines\n");
 	}
 
@@ -707,27 +973,33 @@ vulkan_create_frame_buffers(Vulkan_Info *info) {
 
 internal void
 vulkan_create_command_pool(Vulkan_Info *info) {
-	Vulkan_Queue_Family_Indices queue_family_indices = vulkan_find_queue_families(info->physical_device, info->surface);
-	
 	VkCommandPoolCreateInfo pool_info = {};
 	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	pool_info.queueFamilyIndex = queue_family_indices.graphics_family;
+	pool_info.queueFamilyIndex = info->queue_families.graphics_family;
 
 	if (vkCreateCommandPool(info->device, &pool_info, nullptr, &info->command_pool) != VK_SUCCESS) {
 		logprint("vulkan_create_command_pool()", "failed to create command pool\n");
 	}
+
+	info->transfer_command_pool = VK_NULL_HANDLE;
+	if (info->dedicated_transfer) {
+		pool_info.queueFamilyIndex = info->queue_families.transfer_family;
+		if (vkCreateCommandPool(info->device, &pool_info, nullptr, &info->transfer_command_pool) != VK_SUCCESS) {
+			logprint("vulkan_create_command_pool()", "failed to create transfer command pool\n");
+		}
+	}
 }
 
 internal void
 vulkan_create_command_buffers(Vulkan_Info *info) {
-	info->command_buffers.resize(info->MAX_FRAMES_IN_FLIGHT);
+	info->command_buffers.resize(info->frames_in_flight);
 
 	VkCommandBufferAllocateInfo alloc_info = {};
 	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	alloc_info.commandPool = info->command_pool;
 	alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	alloc_info.commandBufferCount = info->MAX_FRAMES_IN_FLIGHT;
+	alloc_info.commandBufferCount = info->frames_in_flight;
 
 	if (vkAllocateCommandBuffers(info->device, &alloc_info, (VkCommandBuffer*)info->command_buffers.get_data()) != VK_SUCCESS) {
 		logprint("vulkan_create_command_buffer()", "failed to allocate command buffers\n");
@@ -736,9 +1008,9 @@ vulkan_create_command_buffers(Vulkan_Info *info) {
 
 internal void
 vulkan_create_sync_objects(Vulkan_Info *info) {
-	info->image_available_semaphore.resize(info->MAX_FRAMES_IN_FLIGHT);
-	info->render_finished_semaphore.resize(info->MAX_FRAMES_IN_FLIGHT);
-	//info->in_flight_fence.resize(info->MAX_FRAMES_IN_FLIGHT);
+	info->image_available_semaphore.resize(info->frames_in_flight);
+	info->render_finished_semaphore.resize(info->frames_in_flight);
+	//info->in_flight_fence.resize(info->frames_in_flight);
 
 	VkSemaphoreCreateInfo semaphore_info = {};
 	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -747,7 +1019,7 @@ vulkan_create_sync_objects(Vulkan_Info *info) {
 	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	for (u32 i = 0; i < info->MAX_FRAMES_IN_FLIGHT; i++) {
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
 		if (vkCreateSemaphore(info->device, &semaphore_info, nullptr, &info->image_available_semaphore[i]) != VK_SUCCESS ||
 	    	vkCreateSemaphore(info->device, &semaphore_info, nullptr, &info->render_finished_semaphore[i]) != VK_SUCCESS ||
 	    	vkCreateFence    (info->device, &fence_info,     nullptr, &info->in_flight_fence[i]          ) != VK_SUCCESS) {
@@ -800,299 +1072,2255 @@ vulkan_create_buffer(VkDevice device, VkPhysicalDevice physical_device, VkDevice
 	vkBindBufferMemory(device, buffer, buffer_memory, 0);
 }
 
-internal VkCommandBuffer
-vulkan_begin_single_time_commands(VkDevice device, VkCommandPool command_pool) {
-	VkCommandBufferAllocateInfo allocate_info = {};
-	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocate_info.commandPool = command_pool;
-    allocate_info.commandBufferCount = 1;
+//
+// Memory
+//
 
-    VkCommandBuffer command_buffer;
-    vkAllocateCommandBuffers(device, &allocate_info, &command_buffer);
+// rounds in up to the next multiple of alignment (does not have to be a power of two)
+internal VkDeviceSize
+vulkan_get_alignment(VkDeviceSize in, VkDeviceSize alignment) {
+	if (alignment <= 1)
+		return in;
+	return ((in + alignment - 1) / alignment) * alignment;
+}
 
-	VkCommandBufferBeginInfo begin_info = {};
-	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+internal Vulkan_Memory_Range*
+vulkan_memory_new_range(VkDeviceSize offset, VkDeviceSize size, Vulkan_Memory_Range *next) {
+	Vulkan_Memory_Range *range = (Vulkan_Memory_Range*)platform_malloc(sizeof(Vulkan_Memory_Range));
+	range->offset = offset;
+	range->size = size;
+	range->next = next;
+	return range;
+}
 
-	vkBeginCommandBuffer(command_buffer, &begin_info);
+internal Vulkan_Memory_Block*
+vulkan_memory_create_block(Vulkan_Info *info, Vulkan_Memory_Pool *pool, VkDeviceSize min_size, u32 type_filter) {
+	Vulkan_Memory_Block *block = (Vulkan_Memory_Block*)platform_malloc(sizeof(Vulkan_Memory_Block));
+	*block = {};
+	block->size = pool->block_size;
+	if (block->size < min_size)
+		block->size = min_size; // allocation bigger than a block gets its own block
 
-    return command_buffer;
-}
+	VkMemoryRequirements memory_requirements = {};
+	if (pool->buffer_usage) {
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = block->size;
+		buffer_info.usage = pool->buffer_usage;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(info->device, &buffer_info, nullptr, &block->buffer) != VK_SUCCESS) {
+			logprint("vulkan_memory_create_block()", "failed to create block buffer\n");
+			platform_free(block);
+			return 0;
+		}
+		vkGetBufferMemoryRequirements(info->device, block->buffer, &memory_requirements);
+		type_filter &= memory_requirements.memoryTypeBits;
+	} else {
+		memory_requirements.size = block->size;
+	}
 
-internal void
-vulkan_end_single_time_commands(VkCommandBuffer command_buffer, VkDevice device, VkCommandPool command_pool, VkQueue graphics_queue) {
-	vkEndCommandBuffer(command_buffer);
+	block->memory_type_index = vulkan_find_memory_type(info->physical_device, type_filter, pool->properties);
 
-	VkSubmitInfo submit_info = {};
-	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers = &command_buffer;
+	VkMemoryAllocateInfo allocate_info = {};
+	allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocate_info.allocationSize = memory_requirements.size;
+	allocate_info.memoryTypeIndex = block->memory_type_index;
+
+	if (vkAllocateMemory(info->device, &allocate_info, nullptr, &block->memory) != VK_SUCCESS) {
+		logprint("vulkan_memory_create_block()", "failed to allocate block memory\n");
+		if (block->buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(info->device, block->buffer, nullptr);
+		platform_free(block);
+		return 0;
+	}
 
-	vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphics_queue);
+	if (block->buffer != VK_NULL_HANDLE)
+		vkBindBufferMemory(info->device, block->buffer, block->memory, 0);
 
-	vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
-}
+	block->free_ranges = vulkan_memory_new_range(0, block->size, 0);
 
-internal void
-vulkan_copy_buffer(Vulkan_Info *info, VkBuffer src_buffer, VkBuffer dest_buffer, VkDeviceSize size, u32 src_offset, u32 dest_offset) {
-	VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(info->device, info->command_pool);
+	// chain on the end so older blocks get filled first
+	Vulkan_Memory_Block **last = &pool->blocks;
+	while(*last != 0)
+		last = &(*last)->next;
+	*last = block;
+	pool->blocks_count++;
 
-	VkBufferCopy copy_region = {};
-	copy_region.srcOffset = src_offset;  // Optional
-	copy_region.dstOffset = dest_offset; // Optional
-	copy_region.size = size;
-	vkCmdCopyBuffer(command_buffer, src_buffer, dest_buffer, 1, &copy_region);
-		
-	vulkan_end_single_time_commands(command_buffer, info->device, info->command_pool, info->graphics_queue);
+	return block;
 }
 
-// return the offset to the memory set in the buffer
-internal u32
-vulkan_update_buffer(Vulkan_Info *info, VkBuffer *buffer, VkDeviceMemory *memory, void *in_data, u32 in_data_size) {
-	VkDeviceSize buffer_size = in_data_size;
-	VkBuffer staging_buffer;
-	VkDeviceMemory staging_buffer_memory;
-	
-	vulkan_create_buffer(info->device, 
-						 info->physical_device,
-						 buffer_size, 
-						 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-						 staging_buffer,
-						 staging_buffer_memory);
+// first fit search through the free ranges of a block
+internal bool8
+vulkan_memory_block_allocate(Vulkan_Memory_Block *block, VkDeviceSize size, VkDeviceSize alignment, Vulkan_Allocation *allocation) {
+	Vulkan_Memory_Range **link = &block->free_ranges;
+	while(*link != 0) {
+		Vulkan_Memory_Range *range = *link;
+		VkDeviceSize offset = vulkan_get_alignment(range->offset, alignment);
+		VkDeviceSize end = offset + size;
+		VkDeviceSize range_end = range->offset + range->size;
+
+		if (end > range_end) {
+			link = &range->next;
+			continue;
+		}
 
-	void *data;
-	vkMapMemory(info->device, staging_buffer_memory, 0, buffer_size, 0, &data);
-	memcpy(data, in_data, buffer_size);
-	vkUnmapMemory(info->device, staging_buffer_memory);
+		// the padding in front of offset stays in the free list
+		if (offset == range->offset && end == range_end) {
+			*link = range->next;
+			platform_free(range);
+		} else if (offset == range->offset) {
+			range->offset = end;
+			range->size = range_end - end;
+		} else if (end == range_end) {
+			range->size = offset - range->offset;
+		} else {
+			range->size = offset - range->offset;
+			range->next = vulkan_memory_new_range(end, range_end - end, range->next);
+		}
 
-	vulkan_copy_buffer(info, staging_buffer, *buffer, buffer_size, 0, info->combined_buffer_offset);
-	
-	vkDestroyBuffer(info->device, staging_buffer, nullptr);
-	vkFreeMemory(info->device, staging_buffer_memory, nullptr);
+		allocation->block = block;
+		allocation->offset = offset;
+		allocation->size = size;
+		return true;
+	}
 
-    u32 return_offset = info->combined_buffer_offset;
-    info->combined_buffer_offset += in_data_size;
-    return return_offset;
+	return false;
 }
 
-internal void
-vulkan_create_descriptor_set_layout(Vulkan_Info *info) {
-	VkDescriptorSetLayoutBinding ubo_layout_binding = {};
-    ubo_layout_binding.binding = 0;
-    ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    ubo_layout_binding.descriptorCount = 1;
-	ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	ubo_layout_binding.pImmutableSamplers = nullptr; // Optional
-	
-	VkDescriptorSetLayoutBinding sampler_layout_binding = {};
-	sampler_layout_binding.binding = 1;
-	sampler_layout_binding.descriptorCount = 1;
-	sampler_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	sampler_layout_binding.pImmutableSamplers = nullptr;
-	sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+// requirements.memoryTypeBits limits which blocks can be used. buffer pool allocations can pass ~0.
+internal bool8
+vulkan_memory_allocate(Vulkan_Info *info, Vulkan_Memory_Pool *pool, VkMemoryRequirements requirements, Vulkan_Allocation *allocation) {
+	*allocation = {};
+	if (requirements.size == 0)
+		return false;
+
+	for (Vulkan_Memory_Block *block = pool->blocks; block != 0; block = block->next) {
+		if (!(requirements.memoryTypeBits & (1 << block->memory_type_index)))
+			continue;
+		if (vulkan_memory_block_allocate(block, requirements.size, requirements.alignment, allocation))
+			return true;
+	}
 
-	VkDescriptorSetLayoutBinding bindings[] = { ubo_layout_binding, sampler_layout_binding };	
+	Vulkan_Memory_Block *block = vulkan_memory_create_block(info, pool, requirements.size, requirements.memoryTypeBits);
+	if (block == 0)
+		return false;
 
-	VkDescriptorSetLayoutCreateInfo layout_info = {};
-	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layout_info.bindingCount = ARRAY_COUNT(bindings);
-	layout_info.pBindings = bindings;
-	
-	if (vkCreateDescriptorSetLayout(info->device, &layout_info, nullptr, &info->descriptor_set_layout) != VK_SUCCESS) {
-		logprint("vulkan_create_descriptor_set_layout()", "failed to create descriptor set layout\n");
+	if (!vulkan_memory_block_allocate(block, requirements.size, requirements.alignment, allocation)) {
+		logprint("vulkan_memory_allocate()", "new block could not fit allocation\n");
+		return false;
 	}
+
+	return true;
 }
 
+// gives the range back to the block and merges it with the free ranges beside it
 internal void
-vulkan_create_descriptor_pool(Vulkan_Info *info) {
-	VkDescriptorPoolSize pool_sizes[2] = {};
-	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	pool_sizes[0].descriptorCount = info->MAX_FRAMES_IN_FLIGHT;
-	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	pool_sizes[1].descriptorCount = info->MAX_FRAMES_IN_FLIGHT;
+vulkan_memory_free(Vulkan_Allocation *allocation) {
+	Vulkan_Memory_Block *block = allocation->block;
+	if (block == 0)
+		return;
 
-	VkDescriptorPoolCreateInfo pool_info = {};
-	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	pool_info.poolSizeCount = 1;
-	pool_info.pPoolSizes = pool_sizes;
-	pool_info.maxSets = info->MAX_FRAMES_IN_FLIGHT;
+	VkDeviceSize offset = allocation->offset;
+	VkDeviceSize end = allocation->offset + allocation->size;
 
-	if (vkCreateDescriptorPool(info->device, &pool_info, nullptr, &info->descriptor_pool) != VK_SUCCESS) {
-		logprint("vulkan_crate_descriptor_pool()", "failed to create descriptor pool\n");
+	Vulkan_Memory_Range *prev = 0;
+	Vulkan_Memory_Range *next = block->free_ranges;
+	while(next != 0 && next->offset < offset) {
+		prev = next;
+		next = next->next;
+	}
+
+	if (prev != 0 && prev->offset + prev->size == offset) {
+		prev->size += allocation->size;
+		if (next != 0 && next->offset == end) {
+			prev->size += next->size;
+			prev->next = next->next;
+			platform_free(next);
+		}
+	} else if (next != 0 && next->offset == end) {
+		next->offset = offset;
+		next->size += allocation->size;
+	} else {
+		Vulkan_Memory_Range *range = vulkan_memory_new_range(offset, allocation->size, next);
+		if (prev != 0) prev->next = range;
+		else           block->free_ranges = range;
 	}
+
+	*allocation = {};
 }
 
-internal VkDeviceSize
-vulkan_get_alignment(VkDeviceSize in, u32 alignment) {
-	while(in % alignment != 0) {
-		in++;
+internal Vulkan_Allocation
+vulkan_allocate_buffer_memory(Vulkan_Info *info, VkDeviceSize size, VkDeviceSize alignment) {
+	VkMemoryRequirements requirements = {};
+	requirements.size = size;
+	requirements.alignment = alignment;
+	requirements.memoryTypeBits = 0xFFFFFFFF;
+
+	Vulkan_Allocation allocation;
+	if (!vulkan_memory_allocate(info, &info->buffer_pool, requirements, &allocation)) {
+		logprint("vulkan_allocate_buffer_memory()", "failed to allocate buffer memory\n");
+	}
+	return allocation;
+}
+
+// allocates memory for the image out of the image pool and binds it
+internal Vulkan_Allocation
+vulkan_allocate_image_memory(Vulkan_Info *info, VkImage image) {
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(info->device, image, &requirements);
+
+	Vulkan_Allocation allocation;
+	if (!vulkan_memory_allocate(info, &info->image_pool, requirements, &allocation)) {
+		logprint("vulkan_allocate_image_memory()", "failed to allocate image memory\n");
+		return allocation;
 	}
-	return in;
+
+	vkBindImageMemory(info->device, image, allocation.block->memory, allocation.offset);
+	return allocation;
 }
 
 internal void
-vulkan_create_descriptor_sets(Vulkan_Info *info) {
-	Arr<VkDescriptorSetLayout> layouts;
-	layouts.resize(info->MAX_FRAMES_IN_FLIGHT);
-	for (u32 i = 0; i < info->MAX_FRAMES_IN_FLIGHT; i++) {
-		layouts[i] = info->descriptor_set_layout;
+vulkan_init_memory_pools(Vulkan_Info *info) {
+	info->buffer_pool.buffer_usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	info->buffer_pool.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	info->buffer_pool.block_size = VULKAN_MEMORY_BLOCK_SIZE;
+
+	// images get their own pool so that buffers and optimal images never share a block (bufferImageGranularity)
+	info->image_pool.buffer_usage = 0;
+	info->image_pool.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	info->image_pool.block_size = VULKAN_MEMORY_BLOCK_SIZE;
+}
+
+internal void
+vulkan_destroy_memory_pool(VkDevice device, Vulkan_Memory_Pool *pool) {
+	Vulkan_Memory_Block *block = pool->blocks;
+	while(block != 0) {
+		Vulkan_Memory_Block *next_block = block->next;
+
+		Vulkan_Memory_Range *range = block->free_ranges;
+		while(range != 0) {
+			Vulkan_Memory_Range *next_range = range->next;
+			platform_free(range);
+			range = next_range;
+		}
+
+		if (block->buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(device, block->buffer, nullptr);
+		vkFreeMemory(device, block->memory, nullptr);
+		platform_free(block);
+
+		block = next_block;
 	}
 
-	VkDescriptorSetAllocateInfo allocate_info = {};
-	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocate_info.descriptorPool = info->descriptor_pool;
-	allocate_info.descriptorSetCount = (u32)info->MAX_FRAMES_IN_FLIGHT;
-	allocate_info.pSetLayouts = (VkDescriptorSetLayout*)layouts.get_data();
+	pool->blocks = 0;
+	pool->blocks_count = 0;
+}
 
-	info->descriptor_sets.resize(info->MAX_FRAMES_IN_FLIGHT);
-	if (vkAllocateDescriptorSets(info->device, &allocate_info, (VkDescriptorSet*)info->descriptor_sets.get_data()) != VK_SUCCESS) {
-		logprint("vulkan_create_descriptor_sets()", "failed to allocate descriptor sets\n");
+//
+// Uploads
+//
+
+internal void
+vulkan_create_upload_batches(Vulkan_Info *info) {
+	VkCommandBuffer command_buffers[VULKAN_UPLOAD_BATCHES];
+	VkCommandBuffer acquire_command_buffers[VULKAN_UPLOAD_BATCHES];
+
+	VkCommandBufferAllocateInfo allocate_info = {};
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandPool = info->dedicated_transfer ? info->transfer_command_pool : info->command_pool;
+	allocate_info.commandBufferCount = VULKAN_UPLOAD_BATCHES;
+
+	if (vkAllocateCommandBuffers(info->device, &allocate_info, command_buffers) != VK_SUCCESS) {
+		logprint("vulkan_create_upload_batches()", "failed to allocate upload command buffers\n");
 	}
 
-	for (u32 i = 0; i < info->MAX_FRAMES_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo buffer_info = {};
-        buffer_info.buffer = info->combined_buffer;
-        buffer_info.offset = info->uniforms_offset[i];
-        buffer_info.range = info->uniform_size;
+	if (info->dedicated_transfer) {
+		allocate_info.commandPool = info->command_pool;
+		if (vkAllocateCommandBuffers(info->device, &allocate_info, acquire_command_buffers) != VK_SUCCESS) {
+			logprint("vulkan_create_upload_batches()", "failed to allocate acquire command buffers\n");
+		}
+	}
+
+	VkFenceCreateInfo fence_info = {};
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VkSemaphoreCreateInfo semaphore_info = {};
+	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (u32 i = 0; i < VULKAN_UPLOAD_BATCHES; i++) {
+		Vulkan_Upload_Batch *batch = &info->upload_batches[i];
+		*batch = {};
+		batch->command_buffer = command_buffers[i];
+		if (vkCreateFence(info->device, &fence_info, nullptr, &batch->fence) != VK_SUCCESS) {
+			logprint("vulkan_create_upload_batches()", "failed to create upload fence\n");
+		}
+
+		if (info->dedicated_transfer) {
+			batch->acquire_command_buffer = acquire_command_buffers[i];
+			if (vkCreateSemaphore(info->device, &semaphore_info, nullptr, &batch->semaphore) != VK_SUCCESS ||
+				vkCreateFence    (info->device, &fence_info,     nullptr, &batch->acquire_fence) != VK_SUCCESS) {
+				logprint("vulkan_create_upload_batches()", "failed to create upload sync objects\n");
+			}
+		}
+	}
+	info->upload_batch_index = 0;
+}
 
-        VkDescriptorImageInfo image_info = {};
-        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        image_info.imageView = info->texture_image_view;
-        image_info.sampler = info->texture_sampler;
+// submits the acquire half of the ownership transfers on the graphics queue
+internal void
+vulkan_acquire_upload_batch(Vulkan_Info *info, Vulkan_Upload_Batch *batch) {
+	if (!batch->acquire_pending)
+		return;
 
-        VkWriteDescriptorSet descriptor_writes[2] = {};
-        descriptor_writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptor_writes[0].dstSet = info->descriptor_sets[i];
-        descriptor_writes[0].dstBinding = 0;
-        descriptor_writes[0].dstArrayElement = 0;
-        descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptor_writes[0].descriptorCount = 1;
-        descriptor_writes[0].pBufferInfo = &buffer_info;
+	VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
-        descriptor_writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptor_writes[1].dstSet = info->descriptor_sets[i];
-        descriptor_writes[1].dstBinding = 1;
-        descriptor_writes[1].dstArrayElement = 0;
-        descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptor_writes[1].descriptorCount = 1;
-        descriptor_writes[1].pImageInfo = &image_info;
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.waitSemaphoreCount = 1;
+	submit_info.pWaitSemaphores = &batch->semaphore;
+	submit_info.pWaitDstStageMask = &wait_stage;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &batch->acquire_command_buffer;
 
-        vkUpdateDescriptorSets(info->device, ARRAY_COUNT(descriptor_writes), descriptor_writes, 0, nullptr);
+	if (vkQueueSubmit(info->graphics_queue, 1, &submit_info, batch->acquire_fence) != VK_SUCCESS) {
+		logprint("vulkan_acquire_upload_batch()", "failed to submit acquire command buffer\n");
 	}
+
+	batch->acquire_pending = false;
+	batch->acquire_submitted = true;
 }
-/*
+
+// has to be called before a graphics submit that uses what was uploaded
 internal void
-vulkan_setup_uniform_buffers(Vulkan_Info *info) {
-	VkDeviceSize buffer_size = VK_WHOLE_SIZE;
-	VkDeviceSize offset = info->uniforms_offset[0];
-	vkMapMemory(info->device, info->combined_buffer_memory, offset, buffer_size, 0, &info->uniform_buffers_mapped);
+vulkan_acquire_uploads(Vulkan_Info *info) {
+	// oldest batch first
+	for (u32 i = 1; i <= VULKAN_UPLOAD_BATCHES; i++) {
+		vulkan_acquire_upload_batch(info, &info->upload_batches[(info->upload_batch_index + i) % VULKAN_UPLOAD_BATCHES]);
+	}
 }
-*/
+
 internal void
-vulkan_create_image(VkDevice device, VkPhysicalDevice physical_device, u32 width, u32 height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &image_memory) {
-	VkImageCreateInfo image_info = {};
-	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    image_info.imageType = VK_IMAGE_TYPE_2D;
-    image_info.extent.width = width;
-    image_info.extent.height = height;
-    image_info.extent.depth = 1;
-    image_info.mipLevels = 1;
-    image_info.arrayLayers = 1;
-    image_info.format = format;
-    image_info.tiling = tiling;
-    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image_info.usage = usage;
-    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
-    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+vulkan_wait_upload_batch(Vulkan_Info *info, Vulkan_Upload_Batch *batch) {
+	TRACE_FUNCTION();
+	vulkan_acquire_upload_batch(info, batch);
+
+	if (batch->submitted) {
+		vkWaitForFences(info->device, 1, &batch->fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(info->device, 1, &batch->fence);
+		batch->submitted = false;
+	}
 
-	if (vkCreateImage(device, &image_info, nullptr, &image) != VK_SUCCESS) {
-		logprint("vulkan_create_image()", "failed to create image\n");
+	if (batch->acquire_submitted) {
+		vkWaitForFences(info->device, 1, &batch->acquire_fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(info->device, 1, &batch->acquire_fence);
+		batch->acquire_submitted = false;
 	}
+}
 
-	VkMemoryRequirements memory_requirements;
-	vkGetImageMemoryRequirements(device, image, &memory_requirements);
+// returns the command buffer of the open batch. opens one if there is none.
+internal VkCommandBuffer
+vulkan_upload_command_buffer(Vulkan_Info *info) {
+	Vulkan_Upload_Batch *batch = &info->upload_batches[info->upload_batch_index];
+	if (batch->recording)
+		return batch->command_buffer;
 
-	VkMemoryAllocateInfo allocate_info = {};
-	allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocate_info.allocationSize = memory_requirements.size;
-	allocate_info.memoryTypeIndex = vulkan_find_memory_type(physical_device, memory_requirements.memoryTypeBits, properties);
-	
-	if (vkAllocateMemory(device, &allocate_info, nullptr, &image_memory)) {
-		logprint("vulkan_create_image()", "failed to allocate image memory\n");
+	// only stalls if this batch was submitted and the other one was too
+	vulkan_wait_upload_batch(info, batch);
+	vkResetCommandBuffer(batch->command_buffer, 0);
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(batch->command_buffer, &begin_info) != VK_SUCCESS) {
+		logprint("vulkan_upload_command_buffer()", "failed to begin upload command buffer\n");
 	}
 
-	vkBindImageMemory(device, image, image_memory, 0);
+	batch->recording = true;
+	batch->buffer_barriers_count = 0;
+	batch->image_barriers_count = 0;
+	batch->mip_jobs_count = 0;
+	return batch->command_buffer;
 }
 
-internal bool8
-vulkan_has_stencil_component(VkFormat format) {
-	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+// makes room for one more element in a growing array and returns it cleared
+template<typename T>
+internal T*
+vulkan_array_push(T **array, u32 *count, u32 *capacity) {
+	if (*count >= *capacity) {
+		u32 new_capacity = (*capacity == 0) ? 64 : (*capacity * 2);
+		T *new_array = ARRAY_MALLOC(T, new_capacity);
+		if (*array != 0) {
+			platform_memory_copy(new_array, *array, *count * sizeof(T));
+			platform_free(*array);
+		}
+		*array = new_array;
+		*capacity = new_capacity;
+	}
+	T *element = &(*array)[(*count)++];
+	*element = {};
+	return element;
 }
 
+// the buffer range was written by the open batch and is going to be read on the graphics queue
 internal void
-vulkan_transition_image_layout(Vulkan_Info *info, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout) {
-	VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(info->device, info->command_pool);
-	
+vulkan_upload_release_buffer(Vulkan_Info *info, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+	if (!info->dedicated_transfer)
+		return; // one queue family: the barrier in vulkan_flush_uploads() is enough
+
+	Vulkan_Upload_Batch *batch = &info->upload_batches[info->upload_batch_index];
+	VkBufferMemoryBarrier *barrier = vulkan_array_push(&batch->buffer_barriers, &batch->buffer_barriers_count, &batch->buffer_barriers_capacity);
+	barrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier->srcAccessMask = 0;
+	barrier->dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+	barrier->srcQueueFamilyIndex = info->queue_families.transfer_family;
+	barrier->dstQueueFamilyIndex = info->queue_families.graphics_family;
+	barrier->buffer = buffer;
+	barrier->offset = offset;
+	barrier->size = size;
+}
+
+// same as vulkan_upload_release_buffer() but also changes the layout of the image
+internal void
+vulkan_upload_release_image(Vulkan_Info *info, VkImageMemoryBarrier image_barrier) {
+	Vulkan_Upload_Batch *batch = &info->upload_batches[info->upload_batch_index];
+	VkImageMemoryBarrier *barrier = vulkan_array_push(&batch->image_barriers, &batch->image_barriers_count, &batch->image_barriers_capacity);
+	*barrier = image_barrier;
+	barrier->srcAccessMask = 0;
+	barrier->srcQueueFamilyIndex = info->queue_families.transfer_family;
+	barrier->dstQueueFamilyIndex = info->queue_families.graphics_family;
+}
+
+// level 0 has to be written and every level in TRANSFER_DST_OPTIMAL. leaves them all in SHADER_READ_ONLY_OPTIMAL.
+internal void
+vulkan_record_mip_blits(VkCommandBuffer command_buffer, VkImage image, u32 width, u32 height, u32 mip_levels) {
 	VkImageMemoryBarrier barrier = {};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = old_layout;
-	barrier.newLayout = new_layout;
 	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	barrier.image = image;
-	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	barrier.subresourceRange.levelCount = 1;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = 0; // TODO
-	barrier.dstAccessMask = 0; // TODO
 
-	VkPipelineStageFlags source_stage;
+	s32 mip_width = (s32)width;
+	s32 mip_height = (s32)height;
+	for (u32 level = 1; level < mip_levels; level++) {
+		// the level before was just written, it is the source now
+		barrier.subresourceRange.baseMipLevel = level - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		s32 next_width = (mip_width > 1) ? mip_width / 2 : 1;
+		s32 next_height = (mip_height > 1) ? mip_height / 2 : 1;
+
+		VkImageBlit blit = {};
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { mip_width, mip_height, 1 };
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { next_width, next_height, 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+		vkCmdBlitImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		mip_width = next_width;
+		mip_height = next_height;
+	}
+
+	// the last level is only written
+	barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// records the release barriers into the transfer batch and the acquire barriers into acquire_command_buffer
+internal void
+vulkan_record_ownership_transfers(Vulkan_Info *info, Vulkan_Upload_Batch *batch) {
+	VkBufferMemoryBarrier *buffer_releases = ARRAY_MALLOC(VkBufferMemoryBarrier, batch->buffer_barriers_count + 1);
+	VkImageMemoryBarrier *image_releases = ARRAY_MALLOC(VkImageMemoryBarrier, batch->image_barriers_count + 1);
+
+	for (u32 i = 0; i < batch->buffer_barriers_count; i++) {
+		buffer_releases[i] = batch->buffer_barriers[i];
+		buffer_releases[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		buffer_releases[i].dstAccessMask = 0;
+	}
+	for (u32 i = 0; i < batch->image_barriers_count; i++) {
+		image_releases[i] = batch->image_barriers[i];
+		image_releases[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_releases[i].dstAccessMask = 0;
+	}
+
+	if (batch->buffer_barriers_count || batch->image_barriers_count) {
+		vkCmdPipelineBarrier(batch->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, batch->buffer_barriers_count, buffer_releases, batch->image_barriers_count, image_releases);
+	}
+
+	platform_free(buffer_releases);
+	platform_free(image_releases);
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkResetCommandBuffer(batch->acquire_command_buffer, 0);
+	if (vkBeginCommandBuffer(batch->acquire_command_buffer, &begin_info) != VK_SUCCESS) {
+		logprint("vulkan_record_ownership_transfers()", "failed to begin acquire command buffer\n");
+	}
+
+	if (batch->buffer_barriers_count || batch->image_barriers_count) {
+		vkCmdPipelineBarrier(batch->acquire_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, batch->buffer_barriers_count, batch->buffer_barriers, batch->image_barriers_count, batch->image_barriers);
+	}
+
+	for (u32 i = 0; i < batch->mip_jobs_count; i++) {
+		Vulkan_Mip_Job *job = &batch->mip_jobs[i];
+		vulkan_record_mip_blits(batch->acquire_command_buffer, job->image, job->width, job->height, job->mip_levels);
+	}
+
+	if (vkEndCommandBuffer(batch->acquire_command_buffer) != VK_SUCCESS) {
+		logprint("vulkan_record_ownership_transfers()", "failed to record acquire command buffer\n");
+	}
+
+	batch->buffer_barriers_count = 0;
+	batch->image_barriers_count = 0;
+	batch->mip_jobs_count = 0;
+}
+
+// submits the open batch with its fence. does not wait.
+// with a dedicated transfer queue the acquire gets submitted by vulkan_acquire_uploads().
+internal void
+vulkan_flush_uploads(Vulkan_Info *info) {
+	Vulkan_Upload_Batch *batch = &info->upload_batches[info->upload_batch_index];
+	if (!batch->recording)
+		return;
+
+	if (info->dedicated_transfer) {
+		vulkan_record_ownership_transfers(info, batch);
+	} else {
+		// make the copies visible to everything that reads uploaded data
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(batch->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	if (vkEndCommandBuffer(batch->command_buffer) != VK_SUCCESS) {
+		logprint("vulkan_flush_uploads()", "failed to record upload command buffer\n");
+	}
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &batch->command_buffer;
+	if (info->dedicated_transfer) {
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores = &batch->semaphore;
+	}
+
+	if (vkQueueSubmit(info->transfer_queue, 1, &submit_info, batch->fence) != VK_SUCCESS) {
+		logprint("vulkan_flush_uploads()", "failed to submit upload command buffer\n");
+	}
+
+	batch->recording = false;
+	batch->submitted = true;
+	batch->acquire_pending = info->dedicated_transfer;
+	info->upload_batch_index = (info->upload_batch_index + 1) % VULKAN_UPLOAD_BATCHES;
+}
+
+// submits the open batch and waits for every batch to finish
+internal void
+vulkan_wait_uploads(Vulkan_Info *info) {
+	vulkan_flush_uploads(info);
+	for (u32 i = 1; i <= VULKAN_UPLOAD_BATCHES; i++) {
+		vulkan_wait_upload_batch(info, &info->upload_batches[(info->upload_batch_index + i) % VULKAN_UPLOAD_BATCHES]);
+	}
+}
+
+// call after recording into vulkan_upload_command_buffer()
+internal void
+vulkan_upload_command_recorded(Vulkan_Info *info) {
+	if (info->upload_immediate)
+		vulkan_wait_uploads(info);
+}
+
+internal void
+vulkan_destroy_upload_batches(Vulkan_Info *info) {
+	vulkan_wait_uploads(info);
+	for (u32 i = 0; i < VULKAN_UPLOAD_BATCHES; i++) {
+		Vulkan_Upload_Batch *batch = &info->upload_batches[i];
+		vkDestroyFence(info->device, batch->fence, nullptr);
+		if (info->dedicated_transfer) {
+			vkDestroySemaphore(info->device, batch->semaphore, nullptr);
+			vkDestroyFence(info->device, batch->acquire_fence, nullptr);
+		}
+		if (batch->buffer_barriers != 0) platform_free(batch->buffer_barriers);
+		if (batch->image_barriers != 0)  platform_free(batch->image_barriers);
+		if (batch->mip_jobs != 0)        platform_free(batch->mip_jobs);
+	}
+}
+
+//
+// Deletion Queue
+//
+
+// deletions queued while a frame is recorded wait for that frame. the ones queued
+// between frames wait for the next frame that gets submitted.
+internal Vulkan_Deletion*
+vulkan_queue_deletion(Vulkan_Info *info, Vulkan_Deletion_Type type) {
+	Vulkan_Deletion_Queue *queue = info->frame_recording ? &info->deletion_queues[info->current_frame] : &info->deletion_queue_pending;
+	Vulkan_Deletion *deletion = vulkan_array_push(&queue->deletions, &queue->deletions_count, &queue->deletions_capacity);
+	deletion->type = type;
+	return deletion;
+}
+
+internal void
+vulkan_delete_swap_chain_later(Vulkan_Info *info, VkSwapchainKHR swap_chain) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_SWAP_CHAIN)->swap_chain = swap_chain;
+}
+
+internal void
+vulkan_delete_framebuffer_later(Vulkan_Info *info, VkFramebuffer framebuffer) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_FRAMEBUFFER)->framebuffer = framebuffer;
+}
+
+internal void
+vulkan_delete_image_view_later(Vulkan_Info *info, VkImageView image_view) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_IMAGE_VIEW)->image_view = image_view;
+}
+
+// destroys the image and frees its memory
+internal void
+vulkan_delete_image_later(Vulkan_Info *info, VkImage image, Vulkan_Allocation allocation) {
+	Vulkan_Deletion *deletion = vulkan_queue_deletion(info, VULKAN_DELETION_IMAGE);
+	deletion->image = image;
+	deletion->allocation = allocation;
+}
+
+// memory can be VK_NULL_HANDLE if the buffer does not own any
+internal void
+vulkan_delete_buffer_later(Vulkan_Info *info, VkBuffer buffer, VkDeviceMemory memory) {
+	Vulkan_Deletion *deletion = vulkan_queue_deletion(info, VULKAN_DELETION_BUFFER);
+	deletion->buffer = buffer;
+	deletion->memory = memory;
+}
+
+internal void
+vulkan_delete_memory_later(Vulkan_Info *info, VkDeviceMemory memory) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_MEMORY)->memory = memory;
+}
+
+// gives the range back to its memory pool
+internal void
+vulkan_free_allocation_later(Vulkan_Info *info, Vulkan_Allocation allocation) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_ALLOCATION)->allocation = allocation;
+}
+
+internal void
+vulkan_delete_pipeline_later(Vulkan_Info *info, VkPipeline pipeline) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_PIPELINE)->pipeline = pipeline;
+}
+
+internal void
+vulkan_delete_sampler_later(Vulkan_Info *info, VkSampler sampler) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_SAMPLER)->sampler = sampler;
+}
+
+// the set goes back to its pool
+internal void
+vulkan_free_descriptor_set_later(Vulkan_Info *info, VkDescriptorSet descriptor_set, VkDescriptorPool pool) {
+	Vulkan_Deletion *deletion = vulkan_queue_deletion(info, VULKAN_DELETION_DESCRIPTOR_SET);
+	deletion->descriptor_set = descriptor_set;
+	deletion->descriptor_pool = pool;
+}
+
+internal void
+vulkan_free_bindless_index_later(Vulkan_Info *info, u32 bindless_index) {
+	vulkan_queue_deletion(info, VULKAN_DELETION_BINDLESS_INDEX)->bindless_index = bindless_index;
+}
+
+internal void
+vulkan_execute_deletions(Vulkan_Info *info, Vulkan_Deletion_Queue *queue) {
+	for (u32 i = 0; i < queue->deletions_count; i++) {
+		Vulkan_Deletion *deletion = &queue->deletions[i];
+		switch(deletion->type) {
+			case VULKAN_DELETION_SWAP_CHAIN:  vkDestroySwapchainKHR(info->device, deletion->swap_chain, nullptr);   break;
+			case VULKAN_DELETION_FRAMEBUFFER: vkDestroyFramebuffer(info->device, deletion->framebuffer, nullptr);   break;
+			case VULKAN_DELETION_IMAGE_VIEW:  vkDestroyImageView(info->device, deletion->image_view, nullptr);      break;
+			case VULKAN_DELETION_IMAGE: {
+				vkDestroyImage(info->device, deletion->image, nullptr);
+				vulkan_memory_free(&deletion->allocation);
+			} break;
+			case VULKAN_DELETION_BUFFER: {
+				vkDestroyBuffer(info->device, deletion->buffer, nullptr);
+				if (deletion->memory != VK_NULL_HANDLE)
+					vkFreeMemory(info->device, deletion->memory, nullptr);
+			} break;
+			case VULKAN_DELETION_MEMORY:      vkFreeMemory(info->device, deletion->memory, nullptr);                break;
+			case VULKAN_DELETION_ALLOCATION:  vulkan_memory_free(&deletion->allocation);                            break;
+			case VULKAN_DELETION_PIPELINE:    vkDestroyPipeline(info->device, deletion->pipeline, nullptr);         break;
+			case VULKAN_DELETION_SAMPLER:     vkDestroySampler(info->device, deletion->sampler, nullptr);           break;
+			case VULKAN_DELETION_DESCRIPTOR_SET: {
+				vkFreeDescriptorSets(info->device, deletion->descriptor_pool, 1, &deletion->descriptor_set);
+			} break;
+			case VULKAN_DELETION_BINDLESS_INDEX: {
+				Vulkan_Texture_Table *table = &info->textures;
+				*vulkan_array_push(&table->free_indices, &table->free_indices_count, &table->free_indices_capacity) = deletion->bindless_index;
+			} break;
+		}
+	}
+	queue->deletions_count = 0;
+}
+
+// called once the fence of frame_index has signaled. the deletions queued since
+// the last frame was submitted move to this frame.
+internal void
+vulkan_flush_deletion_queue(Vulkan_Info *info, u32 frame_index) {
+	Vulkan_Deletion_Queue *queue = &info->deletion_queues[frame_index];
+	vulkan_execute_deletions(info, queue);
+
+	Vulkan_Deletion_Queue *pending = &info->deletion_queue_pending;
+	for (u32 i = 0; i < pending->deletions_count; i++)
+		*vulkan_array_push(&queue->deletions, &queue->deletions_count, &queue->deletions_capacity) = pending->deletions[i];
+	pending->deletions_count = 0;
+}
+
+// executes every queued deletion. the device has to be idle.
+internal void
+vulkan_flush_deletion_queues(Vulkan_Info *info) {
+	for (u32 i = 0; i < info->frames_in_flight; i++)
+		vulkan_execute_deletions(info, &info->deletion_queues[i]);
+	vulkan_execute_deletions(info, &info->deletion_queue_pending);
+}
+
+// the device has to be idle
+internal void
+vulkan_destroy_deletion_queues(Vulkan_Info *info) {
+	vulkan_flush_deletion_queues(info);
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+		if (info->deletion_queues[i].deletions != 0)
+			platform_free(info->deletion_queues[i].deletions);
+		info->deletion_queues[i] = {};
+	}
+	if (info->deletion_queue_pending.deletions != 0)
+		platform_free(info->deletion_queue_pending.deletions);
+	info->deletion_queue_pending = {};
+}
+
+//
+// Staging
+//
+
+internal void
+vulkan_create_staging_ring(Vulkan_Info *info) {
+	Vulkan_Staging_Ring *ring = &info->staging_ring;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+	// 16 covers the texel/block size of every format we upload
+	ring->alignment = 16;
+	if (properties.limits.optimalBufferCopyOffsetAlignment > ring->alignment)
+		ring->alignment = properties.limits.optimalBufferCopyOffsetAlignment;
+
+	ring->size = vulkan_get_alignment(info->staging_ring_size, ring->alignment);
+	ring->head = 0;
+	ring->tail = 0;
+
+	vulkan_create_buffer(info->device,
+						 info->physical_device,
+						 ring->size,
+						 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						 ring->buffer,
+						 ring->memory);
+
+	if (vkMapMemory(info->device, ring->memory, 0, ring->size, 0, (void**)&ring->mapped) != VK_SUCCESS) {
+		logprint("vulkan_create_staging_ring()", "failed to map staging ring\n");
+	}
+}
+
+internal void
+vulkan_destroy_staging_ring(Vulkan_Info *info) {
+	Vulkan_Staging_Ring *ring = &info->staging_ring;
+	vkUnmapMemory(info->device, ring->memory);
+	vkDestroyBuffer(info->device, ring->buffer, nullptr);
+	vkFreeMemory(info->device, ring->memory, nullptr);
+	*ring = {};
+}
+
+// called once the fence for frame_index has signaled
+internal void
+vulkan_staging_reclaim(Vulkan_Info *info, u32 frame_index) {
+	if (info->staging_frame_heads[frame_index] > info->staging_ring.tail)
+		info->staging_ring.tail = info->staging_frame_heads[frame_index];
+}
+
+// returns false if size can never fit in the ring
+internal bool8
+vulkan_staging_allocate(Vulkan_Info *info, VkDeviceSize size, VkDeviceSize *offset) {
+	Vulkan_Staging_Ring *ring = &info->staging_ring;
+	if (ring->mapped == 0 || size > ring->size)
+		return false;
+
+	for (u32 attempt = 0; attempt < 2; attempt++) {
+		VkDeviceSize position = vulkan_get_alignment(ring->head, ring->alignment);
+		VkDeviceSize start = position % ring->size;
+		if (start + size > ring->size) {
+			// does not fit before the end: skip to the start of the ring
+			position += ring->size - start;
+			start = 0;
+		}
+
+		if (position + size - ring->tail <= ring->size) {
+			ring->head = position + size;
+			*offset = start;
+			return true;
+		}
+
+		// ring is full of data the gpu might still be reading. only upload batches read from it.
+		vulkan_wait_uploads(info);
+		ring->tail = ring->head;
+	}
+
+	return false;
+}
+
+// copies data into the staging ring. returns false if it did not fit.
+internal bool8
+vulkan_staging_write(Vulkan_Info *info, void *data, VkDeviceSize size, VkDeviceSize *offset) {
+	if (!vulkan_staging_allocate(info, size, offset))
+		return false;
+	memcpy(info->staging_ring.mapped + *offset, data, size);
+	return true;
+}
+
+//
+// Uniforms
+//
+
+internal void
+vulkan_create_uniform_arena(Vulkan_Info *info) {
+	Vulkan_Uniform_Arena *arena = &info->uniform_arena;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+	arena->alignment = properties.limits.minUniformBufferOffsetAlignment;
+	arena->frame_size = vulkan_get_alignment(info->uniform_arena_size, arena->alignment);
+	arena->head = 0;
+	arena->dynamic_offset = 0;
+
+	vulkan_create_buffer(info->device,
+						 info->physical_device,
+						 arena->frame_size * info->frames_in_flight,
+						 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						 arena->buffer,
+						 arena->memory);
+
+	if (vkMapMemory(info->device, arena->memory, 0, arena->frame_size * info->frames_in_flight, 0, (void**)&arena->mapped) != VK_SUCCESS) {
+		logprint("vulkan_create_uniform_arena()", "failed to map uniform arena\n");
+	}
+}
+
+internal void
+vulkan_destroy_uniform_arena(Vulkan_Info *info) {
+	Vulkan_Uniform_Arena *arena = &info->uniform_arena;
+	vkUnmapMemory(info->device, arena->memory);
+	vkDestroyBuffer(info->device, arena->buffer, nullptr);
+	vkFreeMemory(info->device, arena->memory, nullptr);
+	*arena = {};
+}
+
+// called once the fence for the current frame has signaled
+inline void
+vulkan_uniform_arena_reset(Vulkan_Info *info) {
+	info->uniform_arena.head = 0;
+	info->uniform_arena.dynamic_offset = 0;
+}
+
+// bump allocates a slice in the region of the current frame.
+// returns where to write it and the dynamic offset to bind it with (offset in the frame's region).
+internal u8*
+vulkan_uniform_allocate(Vulkan_Info *info, VkDeviceSize size, u32 *dynamic_offset) {
+	Vulkan_Uniform_Arena *arena = &info->uniform_arena;
+	VkDeviceSize offset = vulkan_get_alignment(arena->head, arena->alignment);
+	if (offset + size > arena->frame_size) {
+		logprint("vulkan_uniform_allocate()", "uniform arena is full (increase uniform_arena_size)\n");
+		return 0;
+	}
+	arena->head = offset + size;
+	*dynamic_offset = (u32)offset;
+	return arena->mapped + (info->current_frame * arena->frame_size) + offset;
+}
+
+internal void
+vulkan_copy_buffer(Vulkan_Info *info, VkBuffer src_buffer, VkBuffer dest_buffer, VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dest_offset) {
+	VkCommandBuffer command_buffer = vulkan_upload_command_buffer(info);
+
+	VkBufferCopy copy_region = {};
+	copy_region.srcOffset = src_offset;  // Optional
+	copy_region.dstOffset = dest_offset; // Optional
+	copy_region.size = size;
+	vkCmdCopyBuffer(command_buffer, src_buffer, dest_buffer, 1, &copy_region);
+	vulkan_upload_release_buffer(info, dest_buffer, dest_offset, size);
+		
+	vulkan_upload_command_recorded(info);
+}
+
+// copies in_data to the buffer at offset through the staging ring
+internal void
+vulkan_update_buffer(Vulkan_Info *info, VkBuffer buffer, VkDeviceSize offset, void *in_data, u32 in_data_size) {
+	VkDeviceSize buffer_size = in_data_size;
+	VkDeviceSize staging_offset;
+	if (vulkan_staging_write(info, in_data, buffer_size, &staging_offset)) {
+		vulkan_copy_buffer(info, info->staging_ring.buffer, buffer, buffer_size, staging_offset, offset);
+		return;
+	}
+
+	// bigger than the whole ring: fall back to a one off staging buffer
+	VkBuffer staging_buffer;
+	VkDeviceMemory staging_buffer_memory;
+	
+	vulkan_create_buffer(info->device, 
+						 info->physical_device,
+						 buffer_size, 
+						 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						 staging_buffer,
+						 staging_buffer_memory);
+
+	void *data;
+	vkMapMemory(info->device, staging_buffer_memory, 0, buffer_size, 0, &data);
+	memcpy(data, in_data, buffer_size);
+	vkUnmapMemory(info->device, staging_buffer_memory);
+
+	vulkan_copy_buffer(info, staging_buffer, buffer, buffer_size, 0, offset);
+	vulkan_delete_buffer_later(info, staging_buffer, staging_buffer_memory); // the copy lands before the next frame
+}
+
+internal void
+vulkan_update_allocation(Vulkan_Info *info, Vulkan_Allocation *allocation, void *in_data, u32 in_data_size) {
+	if (allocation->block == 0 || in_data_size > allocation->size) {
+		logprint("vulkan_update_allocation()", "data does not fit in allocation\n");
+		return;
+	}
+	vulkan_update_buffer(info, allocation->block->buffer, allocation->offset, in_data, in_data_size);
+}
+
+internal void
+vulkan_create_descriptor_set_layout(Vulkan_Info *info) {
+	VkDescriptorSetLayoutBinding ubo_layout_binding = {};
+    ubo_layout_binding.binding = 0;
+    ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    ubo_layout_binding.descriptorCount = 1;
+	ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	ubo_layout_binding.pImmutableSamplers = nullptr; // Optional
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount = 1;
+	layout_info.pBindings = &ubo_layout_binding;
+	
+	if (vkCreateDescriptorSetLayout(info->device, &layout_info, nullptr, &info->descriptor_set_layout) != VK_SUCCESS) {
+		logprint("vulkan_create_descriptor_set_layout()", "failed to create descriptor set layout\n");
+	}
+
+	// every texture has its own set with this layout
+	VkDescriptorSetLayoutBinding sampler_layout_binding = {};
+	sampler_layout_binding.binding = 0;
+	sampler_layout_binding.descriptorCount = 1;
+	sampler_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	sampler_layout_binding.pImmutableSamplers = nullptr;
+	sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	layout_info.pBindings = &sampler_layout_binding;
+
+	// bindless: one array that is written while frames using other elements are in flight
+	VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {};
+	binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	binding_flags_info.bindingCount = 1;
+	binding_flags_info.pBindingFlags = &binding_flags;
+	if (info->bindless) {
+		sampler_layout_binding.descriptorCount = info->textures.bindless_capacity;
+		layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layout_info.pNext = &binding_flags_info;
+	}
+
+	if (vkCreateDescriptorSetLayout(info->device, &layout_info, nullptr, &info->textures.set_layout) != VK_SUCCESS) {
+		logprint("vulkan_create_descriptor_set_layout()", "failed to create texture descriptor set layout\n");
+	}
+}
+
+internal void
+vulkan_create_descriptor_pool(Vulkan_Info *info) {
+	VkDescriptorPoolSize pool_sizes[1] = {};
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	pool_sizes[0].descriptorCount = info->frames_in_flight;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.poolSizeCount = ARRAY_COUNT(pool_sizes);
+	pool_info.pPoolSizes = pool_sizes;
+	pool_info.maxSets = info->frames_in_flight;
+
+	if (vkCreateDescriptorPool(info->device, &pool_info, nullptr, &info->descriptor_pool) != VK_SUCCESS) {
+		logprint("vulkan_crate_descriptor_pool()", "failed to create descriptor pool\n");
+	}
+}
+
+internal void
+vulkan_create_descriptor_sets(Vulkan_Info *info) {
+	Arr<VkDescriptorSetLayout> layouts;
+	layouts.resize(info->frames_in_flight);
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+		layouts[i] = info->descriptor_set_layout;
+	}
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool = info->descriptor_pool;
+	allocate_info.descriptorSetCount = (u32)info->frames_in_flight;
+	allocate_info.pSetLayouts = (VkDescriptorSetLayout*)layouts.get_data();
+
+	info->descriptor_sets.resize(info->frames_in_flight);
+	if (vkAllocateDescriptorSets(info->device, &allocate_info, (VkDescriptorSet*)info->descriptor_sets.get_data()) != VK_SUCCESS) {
+		logprint("vulkan_create_descriptor_sets()", "failed to allocate descriptor sets\n");
+	}
+
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+        VkDescriptorBufferInfo buffer_info = {};
+        // the region of frame i. the slice in it is picked by the dynamic offset.
+        buffer_info.buffer = info->uniform_arena.buffer;
+        buffer_info.offset = i * info->uniform_arena.frame_size;
+        buffer_info.range = info->uniform_size;
+
+        VkWriteDescriptorSet descriptor_write = {};
+        descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_write.dstSet = info->descriptor_sets[i];
+        descriptor_write.dstBinding = 0;
+        descriptor_write.dstArrayElement = 0;
+        descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptor_write.descriptorCount = 1;
+        descriptor_write.pBufferInfo = &buffer_info;
+
+        vkUpdateDescriptorSets(info->device, 1, &descriptor_write, 0, nullptr);
+	}
+}
+internal void
+vulkan_create_image(Vulkan_Info *info, u32 width, u32 height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImage &image, Vulkan_Allocation &image_memory, u32 mip_levels = 1) {
+	VkImageCreateInfo image_info = {};
+	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = width;
+    image_info.extent.height = height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = tiling;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = usage;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(info->device, &image_info, nullptr, &image) != VK_SUCCESS) {
+		logprint("vulkan_create_image()", "failed to create image\n");
+	}
+
+	image_memory = vulkan_allocate_image_memory(info, image);
+}
+
+internal bool8
+vulkan_has_stencil_component(VkFormat format) {
+	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+internal void
+vulkan_transition_image_layout(Vulkan_Info *info, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, u32 mip_levels = 1) {
+	VkCommandBuffer command_buffer = vulkan_upload_command_buffer(info);
+	
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = old_layout;
+	barrier.newLayout = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mip_levels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = 0; // TODO
+	barrier.dstAccessMask = 0; // TODO
+
+	VkPipelineStageFlags source_stage;
 	VkPipelineStageFlags destination_stage;
 
-	if (new_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-	    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	    if (vulkan_has_stencil_component(format)) {
-	        barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-	    }
-	} else {
-	    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+
+	if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+	    barrier.srcAccessMask = 0;
+	    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	    destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+	    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	    destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	    // the transfer queue can't wait on fragment shader. the layout change happens with the ownership transfer.
+	    if (info->dedicated_transfer) {
+	    	vulkan_upload_release_image(info, barrier);
+	    	vulkan_upload_command_recorded(info);
+	    	return;
+	    }
+	} else {
+	    logprint("vulkan_transition_image_layout()", "unsupported layout transition\n");
+	}
+
+	vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	vulkan_upload_command_recorded(info);
+}
+
+internal void
+vulkan_create_depth_resources(Vulkan_Info *info) {
+	VkFormat depth_format = vulkan_find_depth_format(info->physical_device);
+	vulkan_create_image(info, info->swap_chain_extent.width, info->swap_chain_extent.height, depth_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, info->depth_image, info->depth_image_memory);
+	info->depth_extent = info->swap_chain_extent;
+	info->depth_image_view = vulkan_create_image_view(info->device, info->depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT);
+	// the render pass transitions it from UNDEFINED so it doesn't go through the upload queue
+}
+
+//
+// Textures
+//
+
+internal void
+vulkan_copy_buffer_to_image(Vulkan_Info *info, VkBuffer buffer, VkDeviceSize buffer_offset, VkImage image, u32 mip_level, u32 width, u32 height) {
+	VkCommandBuffer command_buffer = vulkan_upload_command_buffer(info);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = buffer_offset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = mip_level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { width, height, 1 };
+
+	vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	
+	vulkan_upload_command_recorded(info);
+}
+
+// stages the pixels of one level and records the copy
+internal void
+vulkan_upload_image_level(Vulkan_Info *info, void *pixels, VkDeviceSize size, VkImage image, u32 mip_level, u32 width, u32 height) {
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory staging_buffer_memory = VK_NULL_HANDLE;
+    VkDeviceSize staging_offset = 0;
+
+    if (vulkan_staging_write(info, pixels, size, &staging_offset)) {
+    	staging_buffer = info->staging_ring.buffer;
+    } else {
+    	// bigger than the whole ring: fall back to a one off staging buffer
+	    vulkan_create_buffer(info->device, info->physical_device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
+
+		void *data;
+		vkMapMemory(info->device, staging_buffer_memory, 0, size, 0, &data);
+		memcpy(data, pixels, size);
+		vkUnmapMemory(info->device, staging_buffer_memory);
+	}
+
+    vulkan_copy_buffer_to_image(info, staging_buffer, staging_offset, image, mip_level, width, height);
+
+    if (staging_buffer_memory != VK_NULL_HANDLE)
+    	vulkan_delete_buffer_later(info, staging_buffer, staging_buffer_memory);
+}
+
+// levels down to 1x1
+inline u32
+vulkan_mip_levels_count(u32 width, u32 height) {
+	u32 size = (width > height) ? width : height;
+	u32 levels = 1;
+	while (size > 1) {
+		size /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+// vkCmdBlitImage with VK_FILTER_LINEAR needs these for the format
+internal bool8
+vulkan_can_blit_mipmaps(Vulkan_Info *info, VkFormat format) {
+	VkFormatProperties properties = {};
+	vkGetPhysicalDeviceFormatProperties(info->physical_device, format, &properties);
+	VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+	return (properties.optimalTilingFeatures & needed) == needed;
+}
+
+// makes levels 1 to mip_levels - 1 from level 0 on the gpu and moves all of them to SHADER_READ_ONLY_OPTIMAL
+internal void
+vulkan_generate_mipmaps(Vulkan_Info *info, VkImage image, u32 width, u32 height, u32 mip_levels) {
+	VkCommandBuffer command_buffer = vulkan_upload_command_buffer(info);
+
+	if (info->dedicated_transfer) {
+		// ownership moves to the graphics queue in TRANSFER_DST_OPTIMAL and the blits follow the acquire
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mip_levels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vulkan_upload_release_image(info, barrier);
+
+		Vulkan_Upload_Batch *batch = &info->upload_batches[info->upload_batch_index];
+		Vulkan_Mip_Job *job = vulkan_array_push(&batch->mip_jobs, &batch->mip_jobs_count, &batch->mip_jobs_capacity);
+		job->image = image;
+		job->width = width;
+		job->height = height;
+		job->mip_levels = mip_levels;
+	} else {
+		vulkan_record_mip_blits(command_buffer, image, width, height, mip_levels);
+	}
+
+	vulkan_upload_command_recorded(info);
+}
+
+// without linear blits for the format the levels are made with stb_image_resize and uploaded like level 0
+internal void
+vulkan_upload_cpu_mipmaps(Vulkan_Info *info, Bitmap *bitmap, VkFormat format, VkImage image, u32 mip_levels) {
+	u8 *source = bitmap->memory;
+	s32 source_width = bitmap->width;
+	s32 source_height = bitmap->height;
+	s32 channels = bitmap->channels;
+
+	for (u32 level = 1; level < mip_levels; level++) {
+		s32 width = (source_width > 1) ? source_width / 2 : 1;
+		s32 height = (source_height > 1) ? source_height / 2 : 1;
+		u8 *pixels = (u8*)platform_malloc(width * height * channels);
+
+		if (format == VK_FORMAT_R8G8B8A8_SRGB)
+			stbir_resize_uint8_srgb(source, source_width, source_height, source_width * channels, pixels, width, height, width * channels, channels, 3, 0);
+		else
+			stbir_resize_uint8(source, source_width, source_height, source_width * channels, pixels, width, height, width * channels, channels);
+
+		vulkan_upload_image_level(info, pixels, width * height * channels, image, level, (u32)width, (u32)height);
+
+		if (source != bitmap->memory)
+			platform_free(source);
+		source = pixels;
+		source_width = width;
+		source_height = height;
+	}
+
+	if (source != bitmap->memory)
+		platform_free(source);
+}
+
+// cooked bitmaps bring their levels along. they are copied as they are.
+internal void
+vulkan_upload_bitmap_mipmaps(Vulkan_Info *info, Bitmap *bitmap, VkImage image, u32 mip_levels) {
+	u32 width = (u32)bitmap->width;
+	u32 height = (u32)bitmap->height;
+	u8 *level_memory = bitmap->memory;
+
+	for (u32 level = 1; level < mip_levels; level++) {
+		level_memory += texture_level_size(bitmap->format, bitmap->channels, width, height);
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		vulkan_upload_image_level(info, level_memory, texture_level_size(bitmap->format, bitmap->channels, width, height), image, level, width, height);
+	}
+}
+
+// returns the number of levels the image got
+internal u32
+vulkan_create_texture_image(Vulkan_Info *info, Bitmap *bitmap, VkFormat format, bool8 mipmaps, VkImage &image, Vulkan_Allocation &image_memory) {
+	u32 width = (u32)bitmap->width;
+	u32 height = (u32)bitmap->height;
+	u32 mip_levels = mipmaps ? vulkan_mip_levels_count(width, height) : 1;
+	if (bitmap->format != TEXTURE_FORMAT_PIXELS && bitmap->mip_levels < mip_levels)
+		mip_levels = 1; // blocks can not be blitted or resized
+	bool8 has_levels = bitmap->mip_levels >= mip_levels;
+	bool8 blit = (mip_levels > 1) && !has_levels && vulkan_can_blit_mipmaps(info, format);
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (blit)
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	vulkan_create_image(info, width, height, format, VK_IMAGE_TILING_OPTIMAL, usage, image, image_memory, mip_levels);
+
+	vulkan_transition_image_layout(info, image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_levels);
+	vulkan_upload_image_level(info, bitmap->memory, texture_level_size(bitmap->format, bitmap->channels, width, height), image, 0, width, height);
+
+	if (blit) {
+		vulkan_generate_mipmaps(info, image, width, height, mip_levels);
+	} else {
+		if (mip_levels > 1 && has_levels)
+			vulkan_upload_bitmap_mipmaps(info, bitmap, image, mip_levels);
+		else if (mip_levels > 1)
+			vulkan_upload_cpu_mipmaps(info, bitmap, format, image, mip_levels);
+		vulkan_transition_image_layout(info, image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mip_levels);
+	}
+
+	return mip_levels;
+}
+
+// 3 channel formats are barely supported for sampling. those bitmaps get expanded to 4 channels first.
+internal VkFormat
+vulkan_texture_format(s32 channels) {
+	switch(channels) {
+		case 1: return VK_FORMAT_R8_UNORM;
+		case 2: return VK_FORMAT_R8G8_UNORM;
+		case 4: return VK_FORMAT_R8G8B8A8_SRGB;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+internal VkFormat
+vulkan_compressed_format(u32 texture_format) {
+	switch(texture_format) {
+		case TEXTURE_FORMAT_BC1_SRGB: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		case TEXTURE_FORMAT_BC3_SRGB: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case TEXTURE_FORMAT_BC7_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+// the block compressed formats that can be sampled. pixels always can.
+internal u32
+vulkan_query_texture_formats(Vulkan_Info *info) {
+	u32 formats = TEXTURE_FORMAT_BIT(TEXTURE_FORMAT_PIXELS);
+	if (!info->texture_compression_bc)
+		return formats;
+
+	for (u32 texture_format = TEXTURE_FORMAT_PIXELS + 1; texture_format < TEXTURE_FORMATS_COUNT; texture_format++) {
+		VkFormatProperties properties = {};
+		vkGetPhysicalDeviceFormatProperties(info->physical_device, vulkan_compressed_format(texture_format), &properties);
+		VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		if ((properties.optimalTilingFeatures & needed) == needed)
+			formats |= TEXTURE_FORMAT_BIT(texture_format);
+	}
+	return formats;
+}
+
+// same sampling as opengl_init_bitmap()
+internal Vulkan_Sampler_Key
+vulkan_sampler_key(Vulkan_Info *info, u32 texture_parameters) {
+	Vulkan_Sampler_Key key = {};
+	switch(texture_parameters) {
+		case TEXTURE_PARAMETERS_CHAR: {
+			key.mag_filter = VK_FILTER_LINEAR;
+			key.min_filter = VK_FILTER_LINEAR;
+			key.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			key.address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			key.anisotropy = false;
+			key.mipmaps = false;
+		} break;
+
+		case TEXTURE_PARAMETERS_DEFAULT:
+		default: {
+			key.mag_filter = VK_FILTER_NEAREST;
+			key.min_filter = VK_FILTER_NEAREST;
+			key.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			key.address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			key.anisotropy = info->sampler_anisotropy;
+			key.mipmaps = true;
+		} break;
+	}
+	return key;
+}
+
+inline bool8
+vulkan_sampler_key_equal(Vulkan_Sampler_Key a, Vulkan_Sampler_Key b) {
+	return a.mag_filter == b.mag_filter && a.min_filter == b.min_filter && a.mipmap_mode == b.mipmap_mode &&
+	       a.address_mode == b.address_mode && a.anisotropy == b.anisotropy && a.mipmaps == b.mipmaps;
+}
+
+// returns the sampler with these parameters. creates it the first time.
+internal VkSampler
+vulkan_get_sampler(Vulkan_Info *info, Vulkan_Sampler_Key key) {
+	Vulkan_Texture_Table *table = &info->textures;
+	for (u32 i = 0; i < table->samplers_count; i++) {
+		if (vulkan_sampler_key_equal(table->samplers[i].key, key))
+			return table->samplers[i].sampler;
+	}
+
+	if (table->samplers_count == VULKAN_MAX_SAMPLERS) {
+		logprint("vulkan_get_sampler()", "too many samplers. using the first one\n");
+		return table->samplers[0].sampler;
+	}
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+	
+	VkSamplerCreateInfo sampler_info = {};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = key.mag_filter;
+	sampler_info.minFilter = key.min_filter;
+	sampler_info.addressModeU = key.address_mode;
+	sampler_info.addressModeV = key.address_mode;
+	sampler_info.addressModeW = key.address_mode;
+	sampler_info.anisotropyEnable = key.anisotropy ? VK_TRUE : VK_FALSE;
+	sampler_info.maxAnisotropy = key.anisotropy ? properties.limits.maxSamplerAnisotropy : 1.0f;
+	sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	sampler_info.unnormalizedCoordinates = VK_FALSE;
+	sampler_info.compareEnable = VK_FALSE;
+	sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_info.mipmapMode = key.mipmap_mode;
+	sampler_info.mipLodBias = 0.0f;
+	sampler_info.minLod = 0.0f;
+	sampler_info.maxLod = key.mipmaps ? VK_LOD_CLAMP_NONE : 0.0f; // every level the image has
+
+	Vulkan_Sampler *sampler = &table->samplers[table->samplers_count];
+	if (vkCreateSampler(info->device, &sampler_info, nullptr, &sampler->sampler) != VK_SUCCESS) {
+        logprint("vulkan_get_sampler()", "failed to create texture sampler\n");
+        return VK_NULL_HANDLE;
+    }
+    sampler->key = key;
+    table->samplers_count++;
+    return sampler->sampler;
+}
+
+internal VkDescriptorPool
+vulkan_add_texture_pool(Vulkan_Info *info) {
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount = VULKAN_TEXTURE_SETS_PER_POOL;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT; // sets are freed with their texture
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes = &pool_size;
+	pool_info.maxSets = VULKAN_TEXTURE_SETS_PER_POOL;
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	if (vkCreateDescriptorPool(info->device, &pool_info, nullptr, &pool) != VK_SUCCESS) {
+		logprint("vulkan_add_texture_pool()", "failed to create descriptor pool\n");
+		return VK_NULL_HANDLE;
+	}
+
+	Vulkan_Texture_Table *table = &info->textures;
+	*vulkan_array_push(&table->pools, &table->pools_count, &table->pools_capacity) = pool;
+	return pool;
+}
+
+// allocates from the newest pool that has space left
+internal bool8
+vulkan_allocate_texture_set(Vulkan_Info *info, VkDescriptorSet *descriptor_set, VkDescriptorPool *pool) {
+	Vulkan_Texture_Table *table = &info->textures;
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorSetCount = 1;
+	allocate_info.pSetLayouts = &table->set_layout;
+
+	for (s32 i = (s32)table->pools_count - 1; i >= 0; i--) {
+		allocate_info.descriptorPool = table->pools[i];
+		if (vkAllocateDescriptorSets(info->device, &allocate_info, descriptor_set) == VK_SUCCESS) {
+			*pool = table->pools[i];
+			return true;
+		}
+	}
+
+	allocate_info.descriptorPool = vulkan_add_texture_pool(info);
+	if (allocate_info.descriptorPool == VK_NULL_HANDLE || vkAllocateDescriptorSets(info->device, &allocate_info, descriptor_set) != VK_SUCCESS) {
+		logprint("vulkan_allocate_texture_set()", "failed to allocate descriptor set\n");
+		return false;
+	}
+	*pool = allocate_info.descriptorPool;
+	return true;
+}
+
+// returns an unused element of the bindless array
+internal bool8
+vulkan_allocate_bindless_index(Vulkan_Info *info, u32 *index) {
+	Vulkan_Texture_Table *table = &info->textures;
+	if (table->free_indices_count > 0) {
+		*index = table->free_indices[--table->free_indices_count];
+		return true;
+	}
+
+	if (table->bindless_next_index == table->bindless_capacity) {
+		logprint("vulkan_allocate_bindless_index()", "bindless texture array is full (%d)\n", table->bindless_capacity);
+		return false;
+	}
+	*index = table->bindless_next_index++;
+	return true;
+}
+
+// uploads the bitmap and writes its descriptor. returns 0 if it failed.
+internal Vulkan_Texture*
+vulkan_create_texture(Vulkan_Info *info, Bitmap *bitmap, u32 texture_parameters) {
+	Bitmap expanded = {};
+	if (bitmap->format == TEXTURE_FORMAT_PIXELS && bitmap->channels == 3) {
+		expanded.width = bitmap->width;
+		expanded.height = bitmap->height;
+		expanded.channels = 4;
+		expanded.pitch = expanded.width * 4;
+		expanded.memory = (u8*)platform_malloc(expanded.pitch * expanded.height);
+		for (s32 y = 0; y < bitmap->height; y++) {
+			u8 *src = bitmap->memory + (y * bitmap->pitch);
+			u8 *dest = expanded.memory + (y * expanded.pitch);
+			for (s32 x = 0; x < bitmap->width; x++) {
+				dest[x * 4 + 0] = src[x * 3 + 0];
+				dest[x * 4 + 1] = src[x * 3 + 1];
+				dest[x * 4 + 2] = src[x * 3 + 2];
+				dest[x * 4 + 3] = 0xFF;
+			}
+		}
+		bitmap = &expanded;
+	}
+
+	VkFormat format = vulkan_texture_format(bitmap->channels);
+	if (bitmap->format != TEXTURE_FORMAT_PIXELS)
+		format = (info->textures.formats & TEXTURE_FORMAT_BIT(bitmap->format)) ? vulkan_compressed_format(bitmap->format) : VK_FORMAT_UNDEFINED;
+	if (format == VK_FORMAT_UNDEFINED || bitmap->memory == 0) {
+		logprint("vulkan_create_texture()", "bitmap can not be made into a texture (%d channels, format %d)\n", bitmap->channels, bitmap->format);
+		return 0;
+	}
+
+	Vulkan_Sampler_Key sampler_key = vulkan_sampler_key(info, texture_parameters);
+
+	Vulkan_Texture *texture = (Vulkan_Texture*)platform_malloc(sizeof(Vulkan_Texture));
+	*texture = {};
+	texture->format = format;
+	texture->width = (u32)bitmap->width;
+	texture->height = (u32)bitmap->height;
+
+	texture->mip_levels = vulkan_create_texture_image(info, bitmap, format, sampler_key.mipmaps, texture->image, texture->memory);
+	texture->view = vulkan_create_image_view(info->device, texture->image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->mip_levels);
+	texture->sampler = vulkan_get_sampler(info, sampler_key);
+
+	if (expanded.memory != 0)
+		platform_free(expanded.memory);
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_info.imageView = texture->view;
+	image_info.sampler = texture->sampler;
+
+	VkWriteDescriptorSet descriptor_write = {};
+	descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptor_write.dstBinding = 0;
+	descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptor_write.descriptorCount = 1;
+	descriptor_write.pImageInfo = &image_info;
+
+	bool8 written = false;
+	if (info->bindless) {
+		// the element is not used by any frame in flight so it can be written now
+		if (vulkan_allocate_bindless_index(info, &texture->bindless_index)) {
+			descriptor_write.dstSet = info->textures.bindless_set;
+			descriptor_write.dstArrayElement = texture->bindless_index;
+			written = true;
+		}
+	} else if (vulkan_allocate_texture_set(info, &texture->descriptor_set, &texture->descriptor_pool)) {
+		descriptor_write.dstSet = texture->descriptor_set;
+		descriptor_write.dstArrayElement = 0;
+		written = true;
+	}
+
+	if (!written) {
+		// the upload might not be submitted yet
+		vulkan_delete_image_view_later(info, texture->view);
+		vulkan_delete_image_later(info, texture->image, texture->memory);
+		platform_free(texture);
+		return 0;
+	}
+	vkUpdateDescriptorSets(info->device, 1, &descriptor_write, 0, nullptr);
+
+	Vulkan_Texture_Table *table = &info->textures;
+	texture->table_index = table->textures_count;
+	*vulkan_array_push(&table->textures, &table->textures_count, &table->textures_capacity) = texture;
+	return texture;
+}
+
+// the gpu objects are destroyed once the frames in flight are done with them
+internal void
+vulkan_destroy_texture(Vulkan_Info *info, Vulkan_Texture *texture) {
+	Vulkan_Texture_Table *table = &info->textures;
+
+	if (info->bindless)
+		vulkan_free_bindless_index_later(info, texture->bindless_index); // stays in the array until then
+	else if (texture->descriptor_set != VK_NULL_HANDLE)
+		vulkan_free_descriptor_set_later(info, texture->descriptor_set, texture->descriptor_pool);
+	vulkan_delete_image_view_later(info, texture->view);
+	vulkan_delete_image_later(info, texture->image, texture->memory);
+
+	// swap the last texture into its place
+	Vulkan_Texture *last = table->textures[--table->textures_count];
+	table->textures[texture->table_index] = last;
+	last->table_index = texture->table_index;
+
+	if (table->bound == texture)
+		table->bound = 0;
+	platform_free(texture);
+}
+
+// set layout is made by vulkan_create_descriptor_set_layout()
+internal void
+vulkan_create_texture_table(Vulkan_Info *info) {
+	Vulkan_Texture_Table *table = &info->textures;
+	table->formats = vulkan_query_texture_formats(info);
+
+	if (info->bindless) {
+		VkDescriptorPoolSize pool_size = {};
+		pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_size.descriptorCount = table->bindless_capacity;
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+		pool_info.maxSets = 1;
+
+		if (vkCreateDescriptorPool(info->device, &pool_info, nullptr, &table->bindless_pool) != VK_SUCCESS) {
+			logprint("vulkan_create_texture_table()", "failed to create bindless descriptor pool\n");
+		}
+
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = table->bindless_pool;
+		allocate_info.descriptorSetCount = 1;
+		allocate_info.pSetLayouts = &table->set_layout;
+
+		if (vkAllocateDescriptorSets(info->device, &allocate_info, &table->bindless_set) != VK_SUCCESS) {
+			logprint("vulkan_create_texture_table()", "failed to allocate bindless descriptor set\n");
+		}
+	}
+
+	// 1x1 white
+	u8 white[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+	Bitmap bitmap = {};
+	bitmap.memory = white;
+	bitmap.width = 1;
+	bitmap.height = 1;
+	bitmap.channels = 4;
+	bitmap.pitch = 4;
+	table->default_texture = vulkan_create_texture(info, &bitmap, TEXTURE_PARAMETERS_DEFAULT);
+}
+
+inline Vulkan_Texture*
+vulkan_bound_texture(Vulkan_Info *info) {
+	return info->textures.bound ? info->textures.bound : info->textures.default_texture;
+}
+
+// set 1 of the draws recorded now
+inline VkDescriptorSet
+vulkan_bound_texture_set(Vulkan_Info *info) {
+	return info->bindless ? info->textures.bindless_set : vulkan_bound_texture(info)->descriptor_set;
+}
+
+// the device has to be idle
+internal void
+vulkan_destroy_texture_table(Vulkan_Info *info) {
+	Vulkan_Texture_Table *table = &info->textures;
+
+	for (u32 i = 0; i < table->textures_count; i++) {
+		Vulkan_Texture *texture = table->textures[i];
+		vkDestroyImageView(info->device, texture->view, nullptr);
+		vkDestroyImage(info->device, texture->image, nullptr);
+		vulkan_memory_free(&texture->memory);
+		platform_free(texture);
+	}
+	if (table->textures != 0)
+		platform_free(table->textures);
+
+	for (u32 i = 0; i < table->samplers_count; i++)
+		vkDestroySampler(info->device, table->samplers[i].sampler, nullptr);
+
+	// destroying the pools frees the sets
+	for (u32 i = 0; i < table->pools_count; i++)
+		vkDestroyDescriptorPool(info->device, table->pools[i], nullptr);
+	if (table->pools != 0)
+		platform_free(table->pools);
+	if (table->bindless_pool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(info->device, table->bindless_pool, nullptr);
+	if (table->free_indices != 0)
+		platform_free(table->free_indices);
+
+	vkDestroyDescriptorSetLayout(info->device, table->set_layout, nullptr);
+	*table = {};
+}
+
+//
+// GPU Profiler
+//
+
+internal void
+vulkan_create_profiler(Vulkan_Info *info) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	*profiler = {};
+	profiler->frame_ms = -1.0f;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
+
+	u32 queue_families_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(info->physical_device, &queue_families_count, nullptr);
+	VkQueueFamilyProperties *queue_families = ARRAY_MALLOC(VkQueueFamilyProperties, queue_families_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(info->physical_device, &queue_families_count, queue_families);
+	u32 valid_bits = queue_families[info->queue_families.graphics_family].timestampValidBits;
+	platform_free(queue_families);
+
+	if (valid_bits == 0) {
+		logprint("vulkan_create_profiler()", "graphics queue does not support timestamps\n");
+		return;
+	}
+
+	profiler->timestamp_period = properties.limits.timestampPeriod;
+	profiler->timestamp_mask = (valid_bits >= 64) ? ~0ULL : ((1ULL << valid_bits) - 1);
+
+	VkQueryPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	pool_info.queryCount = VULKAN_MAX_GPU_MARKERS * 2;
+
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+		if (vkCreateQueryPool(info->device, &pool_info, nullptr, &profiler->query_pools[i]) != VK_SUCCESS) {
+			logprint("vulkan_create_profiler()", "failed to create query pool\n");
+			return;
+		}
+	}
+
+	profiler->enabled = true;
+}
+
+internal void
+vulkan_destroy_profiler(Vulkan_Info *info) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+		if (profiler->query_pools[i] != VK_NULL_HANDLE)
+			vkDestroyQueryPool(info->device, profiler->query_pools[i], nullptr);
+	}
+	*profiler = {};
+}
+
+// called once the fence of frame_index signaled. does not wait on the queries.
+internal void
+vulkan_profiler_read_back(Vulkan_Info *info, u32 frame_index) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	u32 markers_count = profiler->markers_count[frame_index];
+	if (!profiler->enabled || markers_count == 0)
+		return;
+
+	u64 timestamps[VULKAN_MAX_GPU_MARKERS * 2];
+	VkResult result = vkGetQueryPoolResults(info->device, profiler->query_pools[frame_index], 0, markers_count * 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS)
+		return;
+
+	profiler->timings_count = 0;
+	for (u32 i = 0; i < markers_count; i++) {
+		Vulkan_GPU_Marker *marker = &profiler->markers[frame_index][i];
+		if (!marker->ended)
+			continue;
+
+		u64 start = timestamps[marker->start_query] & profiler->timestamp_mask;
+		u64 end = timestamps[marker->start_query + 1] & profiler->timestamp_mask;
+		u64 ticks = (end - start) & profiler->timestamp_mask;
+
+		Vulkan_GPU_Timing *timing = &profiler->timings[profiler->timings_count++];
+		timing->name = marker->name;
+		timing->depth = marker->depth;
+		timing->ms = (float32)((float64)ticks * (float64)profiler->timestamp_period / 1000000.0);
+	}
+
+	// the first marker of every frame is the whole frame
+	if (profiler->timings_count > 0)
+		profiler->frame_ms = profiler->timings[0].ms;
+}
+
+// starts the frame's markers. has to be outside of a render pass.
+internal void
+vulkan_profiler_start_frame(Vulkan_Info *info) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	if (!profiler->enabled)
+		return;
+
+	vkCmdResetQueryPool(info->command_buffer, profiler->query_pools[info->current_frame], 0, VULKAN_MAX_GPU_MARKERS * 2);
+	profiler->markers_count[info->current_frame] = 0;
+	profiler->open_markers_count = 0;
+	profiler->dropped_markers_count = 0;
+}
+
+// name has to stay valid until the frame was read back (string literals)
+internal void
+vulkan_profiler_marker_begin(Vulkan_Info *info, const char *name) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	u32 *markers_count = &profiler->markers_count[info->current_frame];
+	if (!profiler->enabled)
+		return;
+	if (*markers_count == VULKAN_MAX_GPU_MARKERS) {
+		profiler->dropped_markers_count++; // so the matching end is dropped too
+		return;
+	}
+
+	Vulkan_GPU_Marker *marker = &profiler->markers[info->current_frame][*markers_count];
+	marker->name = name;
+	marker->depth = profiler->open_markers_count;
+	marker->start_query = *markers_count * 2;
+	marker->ended = false;
+
+	profiler->open_markers[profiler->open_markers_count++] = *markers_count;
+	(*markers_count)++;
+
+	vkCmdWriteTimestamp(info->command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, profiler->query_pools[info->current_frame], marker->start_query);
+}
+
+// ends the last marker that was begun
+internal void
+vulkan_profiler_marker_end(Vulkan_Info *info) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	if (!profiler->enabled || profiler->open_markers_count == 0)
+		return;
+	if (profiler->dropped_markers_count > 0) {
+		profiler->dropped_markers_count--;
+		return;
+	}
+
+	u32 marker_index = profiler->open_markers[--profiler->open_markers_count];
+	Vulkan_GPU_Marker *marker = &profiler->markers[info->current_frame][marker_index];
+	marker->ended = true;
+
+	vkCmdWriteTimestamp(info->command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profiler->query_pools[info->current_frame], marker->start_query + 1);
+}
+
+internal void
+vulkan_profiler_print(Vulkan_Info *info) {
+	Vulkan_Profiler *profiler = &info->profiler;
+	for (u32 i = 0; i < profiler->timings_count; i++) {
+		Vulkan_GPU_Timing *timing = &profiler->timings[i];
+		// print() has no widths or precision, the line is formatted first
+		char line[128];
+		u32 length = 0;
+		char_array_appendf(line, sizeof(line), &length, "gpu: %*s%s %.3f ms\n", (s32)timing->depth * 2, "", timing->name, timing->ms);
+		print("%s", line);
 	}
+}
 
-	if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-	    barrier.srcAccessMask = 0;
-	    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	    destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	} else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-	    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-	    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	    destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	} else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-	    barrier.srcAccessMask = 0;
-	    barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+// binds the uniforms and the texture of the next draws on the frame's command buffer.
+// bindless: the array is bound at the start of the frame, only the index is pushed.
+internal void
+vulkan_bind_draw_descriptors(VkCommandBuffer command_buffer, u32 uniform_offset, VkDescriptorSet texture_set, u32 texture_index) {
+    if (vulkan_info.bindless) {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 0, 1, &vulkan_info.descriptor_sets[vulkan_info.current_frame], 1, &uniform_offset);
+        vkCmdPushConstants(command_buffer, vulkan_info.pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(u32), &texture_index);
+    } else {
+        VkDescriptorSet sets[2] = { vulkan_info.descriptor_sets[vulkan_info.current_frame], texture_set };
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 0, 2, sets, 1, &uniform_offset);
+    }
+}
 
-	    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	    destination_stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	} else {
-	    logprint("vulkan_create_texture_image()", "unsupported layout transition\n");
+//
+// Draw List
+//
+
+// adds count instances of mesh to the draw list
+internal void
+vulkan_draw_list_push(Mesh *mesh, const Matrix_4x4 *transforms, u32 count) {
+    Vulkan_Mesh *vulkan_mesh = (Vulkan_Mesh*)mesh->gpu_info;
+    Vulkan_Draw_List *list = &vulkan_info.draw_list;
+
+    Vulkan_Draw *draw = vulkan_array_push(&list->draws, &list->draws_count, &list->draws_capacity);
+    draw->block = vulkan_mesh->allocation.block;
+    draw->uniform_offset = vulkan_info.uniform_arena.dynamic_offset;
+    draw->indices_count = mesh->indices_count;
+    draw->first_index = vulkan_mesh->indices_offset / sizeof(u32);
+    draw->vertex_offset = (s32)(vulkan_mesh->vertices_offset / sizeof(Vertex));
+    draw->instances_count = count;
+    draw->first_transform = list->transforms_count;
+    draw->texture_set = vulkan_bound_texture_set(&vulkan_info);
+    draw->texture_index = vulkan_bound_texture(&vulkan_info)->bindless_index;
+
+    for (u32 i = 0; i < count; i++) {
+        *vulkan_array_push(&list->transforms, &list->transforms_count, &list->transforms_capacity) = transforms[i];
+    }
+}
+
+inline void
+vulkan_draw_list_clear(Vulkan_Draw_List *list) {
+    list->draws_count = 0;
+    list->transforms_count = 0;
+}
+
+// the draw is issued by vulkan_draw_list_submit()
+void vulkan_draw_list_add(Mesh *mesh, const Matrix_4x4 *transform) {
+    if (vulkan_info.frame_skipped)
+        return;
+    vulkan_draw_list_push(mesh, transform, 1);
+}
+
+// records the draws with one vkCmdDrawIndexed each. binds only what changes between draws.
+// firstInstance picks the transforms from the instance buffer bound at instances_offset.
+internal void
+vulkan_record_draws(VkCommandBuffer command_buffer, Vulkan_Draw *draws, u32 draws_count, VkDeviceSize instances_offset) {
+    vkCmdBindVertexBuffers(command_buffer, 1, 1, &vulkan_info.uniform_arena.buffer, &instances_offset);
+
+    Vulkan_Memory_Block *bound_block = 0;
+    u32 bound_uniform_offset = 0;
+    bool8 uniform_bound = false;
+    VkDescriptorSet bound_texture_set = VK_NULL_HANDLE;
+    u32 pushed_texture_index = 0;
+    bool8 texture_index_pushed = false;
+
+    for (u32 i = 0; i < draws_count; i++) {
+        Vulkan_Draw *draw = &draws[i];
+
+        if (draw->block != bound_block) {
+            VkDeviceSize zero_offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &draw->block->buffer, &zero_offset);
+            vkCmdBindIndexBuffer(command_buffer, draw->block->buffer, 0, VK_INDEX_TYPE_UINT32);
+            bound_block = draw->block;
+        }
+
+        if (!uniform_bound || draw->uniform_offset != bound_uniform_offset) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 0, 1, &vulkan_info.descriptor_sets[vulkan_info.current_frame], 1, &draw->uniform_offset);
+            bound_uniform_offset = draw->uniform_offset;
+            uniform_bound = true;
+        }
+
+        if (draw->texture_set != bound_texture_set) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 1, 1, &draw->texture_set, 0, nullptr);
+            bound_texture_set = draw->texture_set; // bindless: only the first draw
+        }
+
+        if (vulkan_info.bindless && (!texture_index_pushed || draw->texture_index != pushed_texture_index)) {
+            vkCmdPushConstants(command_buffer, vulkan_info.pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(u32), &draw->texture_index);
+            pushed_texture_index = draw->texture_index;
+            texture_index_pushed = true;
+        }
+
+        vkCmdDrawIndexed(command_buffer, draw->indices_count, draw->instances_count, draw->first_index, draw->vertex_offset, draw->first_transform);
+    }
+}
+
+// copies the transforms of the draw list to the uniform arena. returns false if they don't fit.
+internal bool8
+vulkan_draw_list_upload_transforms(Vulkan_Draw_List *list, VkDeviceSize *instances_offset) {
+    u32 transforms_offset;
+    Matrix_4x4 *transforms = (Matrix_4x4*)vulkan_uniform_allocate(&vulkan_info, list->transforms_count * sizeof(Matrix_4x4), &transforms_offset);
+    if (transforms == 0)
+        return false;
+
+    memcpy(transforms, list->transforms, list->transforms_count * sizeof(Matrix_4x4));
+    *instances_offset = (vulkan_info.current_frame * vulkan_info.uniform_arena.frame_size) + transforms_offset;
+    return true;
+}
+
+// writes a VkDrawIndexedIndirectCommand for every draw in the list grouped by block,
+// uniform and texture and issues each group with one vkCmdDrawIndexedIndirect.
+// with parallel recording the list is recorded in vulkan_end_frame() instead.
+void vulkan_draw_list_submit() {
+    Vulkan_Draw_List *list = &vulkan_info.draw_list;
+    if (vulkan_info.parallel_recording || list->draws_count == 0)
+        return;
+
+    u32 commands_offset;
+    VkDeviceSize instances_offset;
+    VkDrawIndexedIndirectCommand *commands = (VkDrawIndexedIndirectCommand*)vulkan_uniform_allocate(&vulkan_info, list->draws_count * sizeof(VkDrawIndexedIndirectCommand), &commands_offset);
+    if (commands == 0 || !vulkan_draw_list_upload_transforms(list, &instances_offset)) {
+        vulkan_draw_list_clear(list);
+        return;
+    }
+
+    VkDeviceSize frame_offset = vulkan_info.current_frame * vulkan_info.uniform_arena.frame_size;
+    VkBuffer arena_buffer = vulkan_info.uniform_arena.buffer;
+    vkCmdBindVertexBuffers(vulkan_info.command_buffer, 1, 1, &arena_buffer, &instances_offset);
+
+    for (u32 i = 0; i < list->draws_count; i++)
+        list->draws[i].written = false;
+
+    // there are only a few blocks so find the groups by searching for the next unwritten draw
+    u32 written = 0;
+    u32 search_start = 0;
+    while (written < list->draws_count) {
+        while (list->draws[search_start].written)
+            search_start++;
+
+        Vulkan_Memory_Block *block = list->draws[search_start].block;
+        u32 uniform_offset = list->draws[search_start].uniform_offset;
+        VkDescriptorSet texture_set = list->draws[search_start].texture_set;
+        u32 texture_index = list->draws[search_start].texture_index;
+        u32 group_start = written;
+
+        for (u32 i = search_start; i < list->draws_count; i++) {
+            Vulkan_Draw *draw = &list->draws[i];
+            if (draw->written || draw->block != block || draw->uniform_offset != uniform_offset ||
+                draw->texture_set != texture_set || (vulkan_info.bindless && draw->texture_index != texture_index))
+                continue;
+
+            VkDrawIndexedIndirectCommand *command = &commands[written++];
+            command->indexCount = draw->indices_count;
+            command->instanceCount = draw->instances_count;
+            command->firstIndex = draw->first_index;
+            command->vertexOffset = draw->vertex_offset;
+            command->firstInstance = draw->first_transform;
+            draw->written = true;
+        }
+
+        VkDeviceSize zero_offset = 0;
+        vkCmdBindVertexBuffers(vulkan_info.command_buffer, 0, 1, &block->buffer, &zero_offset);
+        vkCmdBindIndexBuffer(vulkan_info.command_buffer, block->buffer, 0, VK_INDEX_TYPE_UINT32);
+        vulkan_bind_draw_descriptors(vulkan_info.command_buffer, uniform_offset, texture_set, texture_index);
+
+        u32 group_count = written - group_start;
+        if (vulkan_info.multi_draw_indirect) {
+            VkDeviceSize group_offset = frame_offset + commands_offset + (group_start * sizeof(VkDrawIndexedIndirectCommand));
+            vkCmdDrawIndexedIndirect(vulkan_info.command_buffer, arena_buffer, group_offset, group_count, sizeof(VkDrawIndexedIndirectCommand));
+        } else {
+            for (u32 i = group_start; i < written; i++) {
+                VkDrawIndexedIndirectCommand *command = &commands[i];
+                vkCmdDrawIndexed(vulkan_info.command_buffer, command->indexCount, command->instanceCount, command->firstIndex, command->vertexOffset, command->firstInstance);
+            }
+        }
+    }
+
+    vulkan_draw_list_clear(list);
+}
+
+//
+// Parallel Recording
+//
+
+internal void
+vulkan_create_recorder(Vulkan_Info *info) {
+	Vulkan_Recorder *recorder = &info->recorder;
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex = info->queue_families.graphics_family;
+
+	VkCommandBufferAllocateInfo allocate_info = {};
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocate_info.commandBufferCount = 1;
+
+	for (u32 frame = 0; frame < info->frames_in_flight; frame++) {
+		for (u32 job = 0; job < VULKAN_MAX_RECORDING_JOBS; job++) {
+			if (vkCreateCommandPool(info->device, &pool_info, nullptr, &recorder->command_pools[frame][job]) != VK_SUCCESS) {
+				logprint("vulkan_create_recorder()", "failed to create command pool\n");
+			}
+
+			allocate_info.commandPool = recorder->command_pools[frame][job];
+			if (vkAllocateCommandBuffers(info->device, &allocate_info, &recorder->command_buffers[frame][job]) != VK_SUCCESS) {
+				logprint("vulkan_create_recorder()", "failed to allocate secondary command buffer\n");
+			}
+		}
+	}
+}
+
+internal void
+vulkan_destroy_recorder(Vulkan_Info *info) {
+	for (u32 frame = 0; frame < info->frames_in_flight; frame++) {
+		for (u32 job = 0; job < VULKAN_MAX_RECORDING_JOBS; job++) {
+			vkDestroyCommandPool(info->device, info->recorder.command_pools[frame][job], nullptr);
+		}
 	}
+}
 
-	vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+// runs on a worker thread. the job's pool is only used by this job for this frame.
+internal void
+vulkan_recording_job_proc(u32 thread_index, void *data) {
+	TRACE_ZONE("record_job");
+	Vulkan_Recording_Job *job = (Vulkan_Recording_Job*)data;
+
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.renderPass = vulkan_info.render_pass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = vulkan_info.render_pass_info.framebuffer;
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = &inheritance_info;
+
+	if (vkBeginCommandBuffer(job->command_buffer, &begin_info) != VK_SUCCESS) {
+		logprint("vulkan_recording_job_proc()", "failed to begin secondary command buffer\n");
+		return;
+	}
+
+	vkCmdSetViewport(job->command_buffer, 0, 1, &vulkan_info.viewport);
+	vkCmdSetScissor(job->command_buffer, 0, 1, &vulkan_info.scissor);
+	vkCmdBindPipeline(job->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.graphics_pipeline);
+	vulkan_record_draws(job->command_buffer, &vulkan_info.draw_list.draws[job->first_draw], job->draws_count, job->instances_offset);
+
+	if (vkEndCommandBuffer(job->command_buffer) != VK_SUCCESS) {
+		logprint("vulkan_recording_job_proc()", "failed to record secondary command buffer\n");
+	}
+}
+
+// splits the draw list across the work queue and executes the secondary command buffers
+// in a render pass on the frame's command buffer
+internal void
+vulkan_record_parallel(Vulkan_Info *info) {
+	Vulkan_Recorder *recorder = &info->recorder;
+	Vulkan_Draw_List *list = &info->draw_list;
+
+	u32 jobs_count = 0;
+	VkDeviceSize instances_offset = 0;
+	if (list->draws_count > 0 && vulkan_draw_list_upload_transforms(list, &instances_offset)) {
+		u32 max_jobs = recorder->work_queue->threads_count + 1;
+		if (max_jobs > VULKAN_MAX_RECORDING_JOBS)
+			max_jobs = VULKAN_MAX_RECORDING_JOBS;
+
+		jobs_count = (list->draws_count + VULKAN_MIN_DRAWS_PER_JOB - 1) / VULKAN_MIN_DRAWS_PER_JOB;
+		if (jobs_count > max_jobs)
+			jobs_count = max_jobs;
+	}
+
+	// the frame's fence was waited on so the pools can be reset
+	VkCommandBuffer command_buffers[VULKAN_MAX_RECORDING_JOBS];
+	u32 draws_per_job = (jobs_count > 0) ? (list->draws_count + jobs_count - 1) / jobs_count : 0;
+	for (u32 i = 0; i < jobs_count; i++) {
+		vkResetCommandPool(info->device, recorder->command_pools[info->current_frame][i], 0);
+
+		Vulkan_Recording_Job *job = &recorder->jobs[i];
+		job->command_buffer = recorder->command_buffers[info->current_frame][i];
+		job->first_draw = i * draws_per_job;
+		job->draws_count = draws_per_job;
+		if (job->first_draw + job->draws_count > list->draws_count)
+			job->draws_count = list->draws_count - job->first_draw;
+		job->instances_offset = instances_offset;
+
+		command_buffers[i] = job->command_buffer;
+		work_queue_add(recorder->work_queue, vulkan_recording_job_proc, job);
+	}
+	{
+		TRACE_ZONE("wait_record_jobs");
+		work_queue_complete_all(recorder->work_queue);
+	}
 
-	vulkan_end_single_time_commands(command_buffer, info->device, info->command_pool, info->graphics_queue);
+	vulkan_profiler_marker_begin(info, "render_pass");
+	vkCmdBeginRenderPass(info->command_buffer, &info->render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (jobs_count > 0)
+		vkCmdExecuteCommands(info->command_buffer, jobs_count, command_buffers);
+	vkCmdEndRenderPass(info->command_buffer);
+	vulkan_profiler_marker_end(info);
+
+	vulkan_draw_list_clear(list);
 }
 
+//
+// Headless
+//
+
+// stands in for vulkan_create_swap_chain() and gives the frame buffers their color images
 internal void
-vulkan_create_depth_resources(Vulkan_Info *info) {
-	VkFormat depth_format = vulkan_find_depth_format(info->physical_device);
-	vulkan_create_image(info->device, info->physical_device, info->swap_chain_extent.width, info->swap_chain_extent.height, depth_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, info->depth_image, info->depth_image_memory);
-	info->depth_image_view = vulkan_create_image_view(info->device, info->depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT);
-	vulkan_transition_image_layout(info, info->depth_image, depth_format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);	
+vulkan_create_offscreen_images(Vulkan_Info *info) {
+	Vulkan_Headless *headless = &info->headless_target;
+
+	VkFormat candidates[2] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB };
+	info->swap_chain_image_format = vulkan_find_supported_format(info->physical_device, candidates, ARRAY_COUNT(candidates), VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+	info->swap_chain_extent = { (u32)info->window_width, (u32)info->window_height };
+
+	// one per frame in flight so a frame never renders into an image that is still being copied
+	info->swap_chain_images.resize(info->frames_in_flight);
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
+		vulkan_create_image(info, info->swap_chain_extent.width, info->swap_chain_extent.height, info->swap_chain_image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, info->swap_chain_images[i], headless->images_memory[i]);
+	}
+
+	headless->readback_size = info->swap_chain_extent.width * info->swap_chain_extent.height * 4;
+	vulkan_create_buffer(info->device,
+						 info->physical_device,
+						 headless->readback_size,
+						 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+						 headless->readback_buffer,
+						 headless->readback_memory);
+
+	if (vkMapMemory(info->device, headless->readback_memory, 0, headless->readback_size, 0, (void**)&headless->readback_mapped) != VK_SUCCESS) {
+		logprint("vulkan_create_offscreen_images()", "failed to map readback buffer\n");
+	}
+}
+
+internal void
+vulkan_destroy_offscreen_images(Vulkan_Info *info) {
+	Vulkan_Headless *headless = &info->headless_target;
+	for (u32 i = 0; i < info->swap_chain_images.get_size(); i++) {
+		vkDestroyImage(info->device, info->swap_chain_images[i], nullptr);
+		vulkan_memory_free(&headless->images_memory[i]);
+	}
+
+	vkUnmapMemory(info->device, headless->readback_memory);
+	vkDestroyBuffer(info->device, headless->readback_buffer, nullptr);
+	vkFreeMemory(info->device, headless->readback_memory, nullptr);
+}
+
+// copies the frame's image to the readback buffer after the render pass
+internal void
+vulkan_record_readback(Vulkan_Info *info) {
+	Vulkan_Headless *headless = &info->headless_target;
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(info->command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { info->swap_chain_extent.width, info->swap_chain_extent.height, 1 };
+	vkCmdCopyImageToBuffer(info->command_buffer, info->swap_chain_images[info->image_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, headless->readback_buffer, 1, &region);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(info->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	headless->readback_requested = false;
+	headless->readback_recorded = true;
+}
+
+// waits for the read back frame and returns the FNV-1a hash of its pixels. 0 if nothing was read back.
+internal u64
+vulkan_readback_checksum(Vulkan_Info *info) {
+	Vulkan_Headless *headless = &info->headless_target;
+	if (!headless->readback_recorded)
+		return 0;
+
+	vkDeviceWaitIdle(info->device);
+	return fnv1a_64(headless->readback_mapped, (u32)headless->readback_size);
 }
 
 internal void
@@ -1105,11 +3333,17 @@ vulkan_cleanup_swap_chain(Vulkan_Info *info) {
 		vkDestroyImageView(info->device, info->swap_chain_image_views[i], nullptr);
 	}
 
-	vkDestroySwapchainKHR(info->device, info->swap_chains[0], nullptr);
+	if (info->headless)
+		vulkan_destroy_offscreen_images(info);
+	else
+		vkDestroySwapchainKHR(info->device, info->swap_chains[0], nullptr);
 }
 
-internal void
+// returns false if there is no swap chain afterwards. the old one is let go of either way,
+// so the next call starts from scratch instead of queueing its deletion again.
+internal bool8
 vulkan_recreate_swap_chain(Vulkan_Info *info) {
+	TRACE_FUNCTION();
 	if (info->window_width == 0 || info->window_height == 0) {
 		/*SDL_Event event;
 		SDL_WindowEvent *window_event = &event.window;
@@ -1119,63 +3353,108 @@ vulkan_recreate_swap_chain(Vulkan_Info *info) {
 		int i = 0;*/
 	}
 
-	vkDeviceWaitIdle(info->device);
+	// the old swap chain is retired by creating the new one with it as oldSwapchain.
+	// a failed create retires it too, so the next one has to start without it.
+	VkSwapchainKHR old_swap_chain = info->swap_chains[0];
+	bool8 created = vulkan_create_swap_chain(info);
+	if (!created)
+		info->swap_chains[0] = VK_NULL_HANDLE;
+
+	// frames in flight can still use the old resources. they are deleted once the
+	// current frame slot comes around again instead of waiting for the device.
+	for (u32 i = 0; i < info->swap_chain_framebuffers.get_size(); i++)
+		vulkan_delete_framebuffer_later(info, info->swap_chain_framebuffers[i]);
+	for (u32 i = 0; i < info->swap_chain_image_views.get_size(); i++)
+		vulkan_delete_image_view_later(info, info->swap_chain_image_views[i]);
+	if (old_swap_chain != VK_NULL_HANDLE)
+		vulkan_delete_swap_chain_later(info, old_swap_chain);
+
+	if (!created) {
+		info->swap_chain_images.resize(0);
+		info->swap_chain_image_views.resize(0);
+		info->swap_chain_framebuffers.resize(0);
+		return false;
+	}
 
-	vulkan_cleanup_swap_chain(info);
+	vulkan_create_image_views(info);
 
-	vkDestroyImageView(info->device, info->depth_image_view, nullptr);
-    vkDestroyImage(info->device, info->depth_image, nullptr);
-    vkFreeMemory(info->device, info->depth_image_memory, nullptr);
+	// a framebuffer can be smaller than its attachments
+	if (info->swap_chain_extent.width > info->depth_extent.width || info->swap_chain_extent.height > info->depth_extent.height) {
+		vulkan_delete_image_view_later(info, info->depth_image_view);
+		vulkan_delete_image_later(info, info->depth_image, info->depth_image_memory);
+		vulkan_create_depth_resources(info);
+	}
 
-	vulkan_create_swap_chain(info);
-	vulkan_create_image_views(info);
-	vulkan_create_depth_resources(info);
 	vulkan_create_frame_buffers(info);
+	return true;
+}
+
+// the swap chain is rebuilt with the new mode after the next present
+internal void
+vulkan_set_present_mode(Vulkan_Info *info, VkPresentModeKHR present_mode) {
+	info->present_mode = present_mode;
+	if (!info->headless)
+		info->framebuffer_resized = true;
 }
 
 internal void
 vulkan_cleanup(Vulkan_Info *info) {
+	vulkan_destroy_upload_batches(info);
+
 	vulkan_cleanup_swap_chain(info);
+	vulkan_destroy_deletion_queues(info);
 	
 	// Depth buffer
 	vkDestroyImageView(info->device, info->depth_image_view, nullptr);
     vkDestroyImage(info->device, info->depth_image, nullptr);
-    vkFreeMemory(info->device, info->depth_image_memory, nullptr);
+    vulkan_memory_free(&info->depth_image_memory);
 
-	// Texture Image
-	vkDestroySampler(info->device, info->texture_sampler, nullptr);
-	vkDestroyImageView(info->device, info->texture_image_view, nullptr);
-	vkDestroyImage(info->device, info->texture_image, nullptr);
-    vkFreeMemory(info->device, info->texture_image_memory, nullptr);
+	// Textures
+	vulkan_destroy_texture_table(info);
 
 	// Uniform buffer
-	for (u32 i = 0; i < info->MAX_FRAMES_IN_FLIGHT; i++) {
-		//vkDestroyBuffer(info->device, info->uniform_buffers[i], nullptr);
-		//vkFreeMemory(info->device, info->uniform_buffers_memory[i], nullptr);
-	}
+	vulkan_destroy_uniform_arena(info);
+	vulkan_memory_free(&info->identity_instance);
+
+	if (info->draw_list.draws != 0)
+		platform_free(info->draw_list.draws);
+	if (info->draw_list.transforms != 0)
+		platform_free(info->draw_list.transforms);
+
+	if (info->parallel_recording)
+		vulkan_destroy_recorder(info);
+
+	vulkan_destroy_profiler(info);
 
 	vkDestroyDescriptorPool(info->device, info->descriptor_pool, nullptr);
 	vkDestroyDescriptorSetLayout(info->device, info->descriptor_set_layout, nullptr);
 
-	vkDestroyBuffer(info->device, info->combined_buffer, nullptr);
-	vkFreeMemory(info->device, info->combined_buffer_memory, nullptr);
+	vulkan_destroy_staging_ring(info);
+	vulkan_destroy_memory_pool(info->device, &info->buffer_pool);
+	vulkan_destroy_memory_pool(info->device, &info->image_pool);
 	
 	vkDestroyPipeline(info->device, info->graphics_pipeline, nullptr);
 	vkDestroyPipelineLayout(info->device, info->pipeline_layout, nullptr);
+
+	vulkan_save_pipeline_cache(info);
+	vkDestroyPipelineCache(info->device, info->pipeline_cache, nullptr);
 	
 	vkDestroyRenderPass(info->device, info->render_pass, nullptr);
 
-	for (u32 i = 0; i < info->MAX_FRAMES_IN_FLIGHT; i++) {
+	for (u32 i = 0; i < info->frames_in_flight; i++) {
 		vkDestroySemaphore(info->device, info->image_available_semaphore[i], nullptr);
 	    vkDestroySemaphore(info->device, info->render_finished_semaphore[i], nullptr);
 	    vkDestroyFence(info->device, info->in_flight_fence[i], nullptr);
 	}
 	
 	vkDestroyCommandPool(info->device, info->command_pool, nullptr);
+	if (info->transfer_command_pool != VK_NULL_HANDLE)
+		vkDestroyCommandPool(info->device, info->transfer_command_pool, nullptr);
 
 	vkDestroyDevice(info->device, nullptr);
 
-	vkDestroySurfaceKHR(info->instance, info->surface, nullptr);
+	if (info->surface != VK_NULL_HANDLE)
+		vkDestroySurfaceKHR(info->instance, info->surface, nullptr);
 	
 	if (info->validation_layers.enable)
 		vulkan_destroy_debug_utils_messenger_ext(info->instance, info->debug_messenger, nullptr);
@@ -1183,85 +3462,6 @@ vulkan_cleanup(Vulkan_Info *info) {
 	vkDestroyInstance(info->instance, nullptr);
 }
 
-internal void
-vulkan_copy_buffer_to_image(Vulkan_Info *info, VkBuffer buffer, VkImage image, u32 width, u32 height) {
-	VkCommandBuffer command_buffer = vulkan_begin_single_time_commands(info->device, info->command_pool);
-
-	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-	region.imageOffset = { 0, 0, 0 };
-	region.imageExtent = { width, height, 1 };
-
-	vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-	
-	vulkan_end_single_time_commands(command_buffer, info->device, info->command_pool, info->graphics_queue);
-}
-
-// TODO: Make it so that images can be created asynchronously (vulkan-tutorial = Texture mapping/Images)
-
-internal void
-vulkan_create_texture_image(Vulkan_Info *info, Bitmap *bitmap) {
-    VkDeviceSize image_size = bitmap->width * bitmap->height * bitmap->channels;
-
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-
-    vulkan_create_buffer(info->device, info->physical_device, image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-	void *data;
-	vkMapMemory(info->device, staging_buffer_memory, 0, image_size, 0, &data);
-	memcpy(data, bitmap->memory, image_size);
-	vkUnmapMemory(info->device, staging_buffer_memory);
-
-	vulkan_create_image(info->device, info->physical_device, bitmap->width, bitmap->height, info->texture_image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, info->texture_image, info->texture_image_memory);
-
-	vulkan_transition_image_layout(info, info->texture_image, info->texture_image_format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    vulkan_copy_buffer_to_image(info, staging_buffer, info->texture_image, (u32)bitmap->width, (u32)bitmap->height);
-    vulkan_transition_image_layout(info, info->texture_image, info->texture_image_format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(info->device, staging_buffer, nullptr);
-    vkFreeMemory(info->device, staging_buffer_memory, nullptr);
-}
-
-internal void
-vulkan_create_texture_image_view(Vulkan_Info *info) {
-	info->texture_image_view = vulkan_create_image_view(info->device, info->texture_image, info->texture_image_format, VK_IMAGE_ASPECT_COLOR_BIT);
-}
-
-internal void
-vulkan_create_texture_sampler(Vulkan_Info *info) {
-	VkPhysicalDeviceProperties properties = {};
-	vkGetPhysicalDeviceProperties(info->physical_device, &properties);
-	
-	VkSamplerCreateInfo sampler_info = {};
-	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	sampler_info.magFilter = VK_FILTER_LINEAR;
-	sampler_info.minFilter = VK_FILTER_LINEAR;
-	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	sampler_info.anisotropyEnable = VK_TRUE;
-	sampler_info.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-	sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	sampler_info.unnormalizedCoordinates = VK_FALSE;
-	sampler_info.compareEnable = VK_FALSE;
-	sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
-	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	sampler_info.mipLodBias = 0.0f;
-	sampler_info.minLod = 0.0f;
-	sampler_info.maxLod = 0.0f;
-
-	if (vkCreateSampler(info->device, &sampler_info, nullptr, &info->texture_sampler) != VK_SUCCESS) {
-        logprint("vulkan_create_texture_sampler()", "failed to create texture sampler\n");
-    }
-}
-
 internal void
 vulkan_init_presentation_settings(Vulkan_Info *info) {
 
@@ -1293,12 +3493,12 @@ vulkan_init_presentation_settings(Vulkan_Info *info) {
 
 	// End of frame
 	info->submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	info->submit_info.waitSemaphoreCount = 1;
+	info->submit_info.waitSemaphoreCount = info->headless ? 0 : 1; // nothing is acquired or presented headless
 	info->submit_info.pWaitSemaphores = &info->image_available_semaphore[info->current_frame];
 	info->submit_info.pWaitDstStageMask = info->wait_stages;
 	info->submit_info.commandBufferCount = 1;
 	info->submit_info.pCommandBuffers = &info->command_buffers[info->current_frame];	
-	info->submit_info.signalSemaphoreCount = 1;
+	info->submit_info.signalSemaphoreCount = info->headless ? 0 : 1;
 	info->submit_info.pSignalSemaphores = &info->render_finished_semaphore[info->current_frame];
 
 	info->present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1316,6 +3516,10 @@ vulkan_update_presentation_settings(Vulkan_Info *info) {
 
 	// Start of frame
 	info->render_pass_info.framebuffer = info->swap_chain_framebuffers[info->image_index];
+	info->render_pass_info.renderArea.extent = info->swap_chain_extent; // changes when the swap chain is recreated
+	info->scissor.extent = info->swap_chain_extent;
+	info->viewport.width = static_cast<float>(info->swap_chain_extent.width);
+	info->viewport.height = static_cast<float>(info->swap_chain_extent.height);
 
 	// End of frame
 	info->submit_info.pWaitSemaphores = &info->image_available_semaphore[info->current_frame];
@@ -1334,23 +3538,63 @@ void vulkan_clear_color(Vector4 color) {
 	vulkan_info.clear_values[0].color = {{color.r, color.g, color.b, color.a}};
 }
 
+// low latency pacing: blocks until the frame slot vulkan_start_frame() is going to use is
+// free, so input sampled after this is as fresh as it can be when the frame is recorded.
+void vulkan_wait_for_frame() {
+	TRACE_FUNCTION();
+	vkWaitForFences(vulkan_info.device, 1, &vulkan_info.in_flight_fence[vulkan_info.current_frame], VK_TRUE, UINT64_MAX);
+}
+
 void vulkan_start_frame() {
+	TRACE_FUNCTION();
 	vulkan_info.command_buffer = vulkan_info.command_buffers[vulkan_info.current_frame];
 
 	// Waiting for the previous frame
-	vkWaitForFences(vulkan_info.device, 1, &vulkan_info.in_flight_fence[vulkan_info.current_frame], VK_TRUE, UINT64_MAX);
-	VkResult result = vkAcquireNextImageKHR(vulkan_info.device,
-                                            vulkan_info.swap_chains[0],
-                                            UINT64_MAX,
-                                            vulkan_info.image_available_semaphore[vulkan_info.current_frame],
-                                            VK_NULL_HANDLE,
-                                            &vulkan_info.image_index);
-
-	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-         vulkan_recreate_swap_chain(&vulkan_info);
-		return;
-	} else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-		logprint("vulkan_draw_frame()", "failed to acquire swap chain");
+	{
+		TRACE_ZONE("wait_frame_fence");
+		vkWaitForFences(vulkan_info.device, 1, &vulkan_info.in_flight_fence[vulkan_info.current_frame], VK_TRUE, UINT64_MAX);
+	}
+	vulkan_staging_reclaim(&vulkan_info, vulkan_info.current_frame);
+	vulkan_uniform_arena_reset(&vulkan_info);
+	vulkan_profiler_read_back(&vulkan_info, vulkan_info.current_frame);
+	vulkan_flush_deletion_queue(&vulkan_info, vulkan_info.current_frame);
+	vulkan_info.frame_recording = true;
+
+	if (vulkan_info.headless) {
+		// the frame slot's image is free once its fence has signaled
+		vulkan_info.image_index = vulkan_info.current_frame;
+	} else {
+		TRACE_ZONE("vkAcquireNextImageKHR");
+		// the semaphore is not signaled when the acquire fails so it can be used for the retry.
+		// the swap chain gets recreated once. if it is still out of date (the window keeps
+		// being resized) or it can not be made (minimized) the frame is skipped.
+		bool8 acquired = false;
+		bool8 has_swap_chain = vulkan_info.swap_chains[0] != VK_NULL_HANDLE || vulkan_recreate_swap_chain(&vulkan_info);
+		for (u32 attempt = 0; has_swap_chain && attempt < 2; attempt++) {
+			VkResult result = vkAcquireNextImageKHR(vulkan_info.device,
+		                                            vulkan_info.swap_chains[0],
+		                                            UINT64_MAX,
+		                                            vulkan_info.image_available_semaphore[vulkan_info.current_frame],
+		                                            VK_NULL_HANDLE,
+		                                            &vulkan_info.image_index);
+
+			if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+				acquired = true;
+				break;
+			} else if (result != VK_ERROR_OUT_OF_DATE_KHR) {
+				logprint("vulkan_draw_frame()", "failed to acquire swap chain\n");
+				break;
+			} else if (attempt == 0) {
+				has_swap_chain = vulkan_recreate_swap_chain(&vulkan_info);
+			}
+		}
+
+		if (!acquired) {
+			// the fence stays signaled. vulkan_end_frame() moves on to the next frame slot so the
+			// deletions the recreate queued in this one still wait for the frames in flight.
+			vulkan_info.frame_skipped = true;
+			return;
+		}
 	}
 
 	vulkan_update_presentation_settings(&vulkan_info);
@@ -1362,38 +3606,90 @@ void vulkan_start_frame() {
 		logprint("vulkan_record_command_buffer()", "failed to begin recording command buffer\n");
 	}	
 
+	vulkan_profiler_start_frame(&vulkan_info);
+	vulkan_profiler_marker_begin(&vulkan_info, "frame");
+
+	// with parallel recording the render pass is recorded in vulkan_end_frame()
+	if (vulkan_info.parallel_recording)
+		return;
+
+	vulkan_profiler_marker_begin(&vulkan_info, "render_pass");
 	vkCmdBeginRenderPass(vulkan_info.command_buffer, &vulkan_info.render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
 	vkCmdSetViewport(vulkan_info.command_buffer, 0, 1, &vulkan_info.viewport);
 	vkCmdSetScissor(vulkan_info.command_buffer, 0, 1, &vulkan_info.scissor);
 	vkCmdBindPipeline(vulkan_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.graphics_pipeline);
+	if (vulkan_info.bindless)
+		vkCmdBindDescriptorSets(vulkan_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_info.pipeline_layout, 1, 1, &vulkan_info.textures.bindless_set, 0, nullptr);
 }
 
 void vulkan_end_frame() {
-	vkCmdEndRenderPass(vulkan_info.command_buffer);
+	TRACE_FUNCTION();
+	if (vulkan_info.frame_skipped) {
+		vulkan_draw_list_clear(&vulkan_info.draw_list);
+		vulkan_info.frame_skipped = false;
+		vulkan_info.frame_recording = false;
+		vulkan_info.current_frame = (vulkan_info.current_frame + 1) % vulkan_info.frames_in_flight;
+		return;
+	}
+
+	if (vulkan_info.parallel_recording)
+		vulkan_record_parallel(&vulkan_info);
+	else {
+		// draw group markers left open end with the render pass
+		while (vulkan_info.profiler.open_markers_count > 2)
+			vulkan_profiler_marker_end(&vulkan_info);
+		vkCmdEndRenderPass(vulkan_info.command_buffer);
+		vulkan_profiler_marker_end(&vulkan_info); // render_pass
+	}
+
+	if (vulkan_info.headless && vulkan_info.headless_target.readback_requested)
+		vulkan_record_readback(&vulkan_info);
+
+	vulkan_profiler_marker_end(&vulkan_info); // frame
 
 	if (vkEndCommandBuffer(vulkan_info.command_buffer) != VK_SUCCESS) {
 		logprint("vulkan_record_command_buffer()", "failed to record command buffer\n");
 	}
 
-	if (vkQueueSubmit(vulkan_info.graphics_queue, 1, &vulkan_info.submit_info, vulkan_info.in_flight_fence[vulkan_info.current_frame]) != VK_SUCCESS) {
-		logprint("vulkan_draw_frame()", "failed to submit draw command buffer\n");
+	// uploads recorded before this point land before the frame on the queue.
+	// with a dedicated transfer queue the acquire submit waits on the transfer.
+	vulkan_flush_uploads(&vulkan_info);
+	vulkan_acquire_uploads(&vulkan_info);
+
+	{
+		TRACE_ZONE("vkQueueSubmit");
+		if (vkQueueSubmit(vulkan_info.graphics_queue, 1, &vulkan_info.submit_info, vulkan_info.in_flight_fence[vulkan_info.current_frame]) != VK_SUCCESS) {
+			logprint("vulkan_draw_frame()", "failed to submit draw command buffer\n");
+		}
+	}
+	vulkan_info.frame_recording = false;
+	// staging space used up to now is free once this frame's fence signals
+	vulkan_info.staging_frame_heads[vulkan_info.current_frame] = vulkan_info.staging_ring.head;
+
+	if (vulkan_info.headless) {
+		vulkan_info.current_frame = (vulkan_info.current_frame + 1) % vulkan_info.frames_in_flight;
+		return;
 	}
 	
-	VkResult result = vkQueuePresentKHR(vulkan_info.present_queue, &vulkan_info.present_info);
+	VkResult result;
+	{
+		TRACE_ZONE("vkQueuePresentKHR");
+		result = vkQueuePresentKHR(vulkan_info.present_queue, &vulkan_info.present_info);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vulkan_info.framebuffer_resized) {
 		vulkan_info.framebuffer_resized = false;
-		vulkan_recreate_swap_chain(&vulkan_info);
-		return;
+		vulkan_recreate_swap_chain(&vulkan_info); // does not wait on the gpu
 	} else if (result != VK_SUCCESS) {
 		logprint("vulkan_draw_frame()", "failed to acquire swap chain");
 	}
 
-	vulkan_info.current_frame = (vulkan_info.current_frame + 1) % vulkan_info.MAX_FRAMES_IN_FLIGHT;
+	vulkan_info.current_frame = (vulkan_info.current_frame + 1) % vulkan_info.frames_in_flight;
 }
 
 void vulkan_init_mesh(Mesh *mesh) {
     Vulkan_Mesh *vulkan_mesh = (Vulkan_Mesh*)platform_malloc(sizeof(Vulkan_Mesh));
+    *vulkan_mesh = {};
 
     u32 vertices_size = mesh->vertices_count * sizeof(Vertex);
     u32 indices_size = mesh->indices_count * sizeof(u32);   
@@ -1404,27 +3700,120 @@ void vulkan_init_mesh(Mesh *mesh) {
     memcpy(memory, (void*)mesh->vertices, vertices_size);
     memcpy((char*)memory + vertices_size, (void*)mesh->indices, indices_size);
 
-    vulkan_mesh->vertices_offset = vulkan_update_buffer(&vulkan_info, &vulkan_info.combined_buffer, &vulkan_info.combined_buffer_memory, memory, buffer_size);
+    // aligned to a vertex so the draw list can address the vertices with a vertex offset
+    vulkan_mesh->allocation = vulkan_allocate_buffer_memory(&vulkan_info, buffer_size, sizeof(Vertex));
+    vulkan_update_allocation(&vulkan_info, &vulkan_mesh->allocation, memory, buffer_size);
+    vulkan_mesh->vertices_offset = (u32)vulkan_mesh->allocation.offset;
     vulkan_mesh->indices_offset = vulkan_mesh->vertices_offset + vertices_size;
     
     platform_free(memory);
     mesh->gpu_info = (void*)vulkan_mesh;
 }
 
+// gives the mesh's memory back to the buffer pool once the frames in flight are done with it.
+// mesh->gpu_info is freed by free_mesh()
+void vulkan_free_mesh(Mesh *mesh) {
+    Vulkan_Mesh *vulkan_mesh = (Vulkan_Mesh*)mesh->gpu_info;
+    if (vulkan_mesh == 0)
+        return;
+    
+    vulkan_free_allocation_later(&vulkan_info, vulkan_mesh->allocation);
+    vulkan_mesh->allocation = {};
+}
+
 void vulkan_draw_mesh(Mesh *mesh) {
+    if (vulkan_info.frame_skipped)
+        return;
+
+    if (vulkan_info.parallel_recording) {
+        Matrix_4x4 identity = identity_m4x4();
+        vulkan_draw_list_push(mesh, &identity, 1);
+        return;
+    }
+
     Vulkan_Mesh *vulkan_mesh = (Vulkan_Mesh*)mesh->gpu_info;
-    VkDeviceSize offsets[] = { vulkan_mesh->vertices_offset };
-    vkCmdBindVertexBuffers(vulkan_info.command_buffer, 0, 1, &vulkan_info.combined_buffer, offsets);
-    vkCmdBindIndexBuffer(vulkan_info.command_buffer, vulkan_info.combined_buffer, vulkan_mesh->indices_offset, VK_INDEX_TYPE_UINT32);
+    VkBuffer buffers[2] = { vulkan_mesh->allocation.block->buffer, vulkan_info.identity_instance.block->buffer };
+    VkDeviceSize offsets[2] = { vulkan_mesh->vertices_offset, vulkan_info.identity_instance.offset };
+    vulkan_bind_draw_descriptors(vulkan_info.command_buffer, vulkan_info.uniform_arena.dynamic_offset, vulkan_bound_texture_set(&vulkan_info), vulkan_bound_texture(&vulkan_info)->bindless_index);
+    vkCmdBindVertexBuffers(vulkan_info.command_buffer, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(vulkan_info.command_buffer, buffers[0], vulkan_mesh->indices_offset, VK_INDEX_TYPE_UINT32);
     vkCmdDrawIndexed(vulkan_info.command_buffer, mesh->indices_count, 1, 0, 0, 0);
 }
 
+// one draw for count copies of the mesh. transforms get multiplied with the model matrix in the ubo.
+void vulkan_draw_mesh_instanced(Mesh *mesh, const Matrix_4x4 *transforms, u32 count) {
+    if (count == 0 || vulkan_info.frame_skipped)
+        return;
+
+    if (vulkan_info.parallel_recording) {
+        vulkan_draw_list_push(mesh, transforms, count);
+        return;
+    }
+
+    u32 instances_offset;
+    u8 *instances = vulkan_uniform_allocate(&vulkan_info, count * sizeof(Matrix_4x4), &instances_offset);
+    if (instances == 0)
+        return;
+    memcpy(instances, transforms, count * sizeof(Matrix_4x4));
+
+    Vulkan_Mesh *vulkan_mesh = (Vulkan_Mesh*)mesh->gpu_info;
+    VkBuffer buffers[2] = { vulkan_mesh->allocation.block->buffer, vulkan_info.uniform_arena.buffer };
+    VkDeviceSize offsets[2] = { vulkan_mesh->vertices_offset, (vulkan_info.current_frame * vulkan_info.uniform_arena.frame_size) + instances_offset };
+    vulkan_bind_draw_descriptors(vulkan_info.command_buffer, vulkan_info.uniform_arena.dynamic_offset, vulkan_bound_texture_set(&vulkan_info), vulkan_bound_texture(&vulkan_info)->bindless_index);
+    vkCmdBindVertexBuffers(vulkan_info.command_buffer, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(vulkan_info.command_buffer, buffers[0], vulkan_mesh->indices_offset, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(vulkan_info.command_buffer, mesh->indices_count, count, 0, 0, 0);
+}
+
+// gpu_handle points to a Vulkan_Texture in the texture table
+void vulkan_init_bitmap(Bitmap *bitmap, u32 texture_parameters) {
+    bitmap->gpu_handle = (void*)vulkan_create_texture(&vulkan_info, bitmap, texture_parameters);
+}
+
+void vulkan_free_bitmap(Bitmap *bitmap) {
+    if (bitmap->gpu_handle == 0)
+        return;
+
+    vulkan_destroy_texture(&vulkan_info, (Vulkan_Texture*)bitmap->gpu_handle);
+    bitmap->gpu_handle = 0;
+}
+
+// the draws after this sample bitmap. 0 binds the default texture.
+void vulkan_bind_bitmap(Bitmap *bitmap) {
+    vulkan_info.textures.bound = bitmap ? (Vulkan_Texture*)bitmap->gpu_handle : 0;
+}
+
+// gives the draws after this call their own copy of matrices. has to be called after vulkan_start_frame().
 internal void
 vulkan_update_uniform_buffer_object(Uniform_Buffer_Object ubo, Matrices matrices) {
-    u32 memory_size = (u32)vulkan_info.uniforms_offset[1] + sizeof(Matrices);
-    void *memory = platform_malloc(memory_size);
-    memcpy((char*)memory + vulkan_info.uniforms_offset[0], (void*)&matrices, sizeof(Matrices));
-    memcpy((char*)memory + vulkan_info.uniforms_offset[1], (void*)&matrices, sizeof(Matrices));
-    vulkan_update_buffer(&vulkan_info, &vulkan_info.combined_buffer, &vulkan_info.combined_buffer_memory, memory, memory_size);
-    platform_free(memory);
+    u32 dynamic_offset;
+    u8 *slice = vulkan_uniform_allocate(&vulkan_info, sizeof(Matrices), &dynamic_offset);
+    if (slice == 0)
+        return; // keep using the last slice
+    memcpy(slice, &matrices, sizeof(Matrices));
+    vulkan_info.uniform_arena.dynamic_offset = dynamic_offset;
+}
+
+// draw group marker. name has to stay valid for frames_in_flight frames (string literals).
+// ignored with parallel recording because the draws are recorded in vulkan_end_frame().
+void vulkan_gpu_marker_begin(const char *name) {
+    if (vulkan_info.parallel_recording || vulkan_info.frame_skipped)
+        return;
+    vulkan_profiler_marker_begin(&vulkan_info, name);
+}
+
+void vulkan_gpu_marker_end() {
+    if (vulkan_info.parallel_recording || vulkan_info.frame_skipped)
+        return;
+    vulkan_profiler_marker_end(&vulkan_info);
+}
+
+// gpu time of the latest frame that was read back. < 0 if there is none.
+float32 vulkan_gpu_frame_time() {
+    return vulkan_info.profiler.frame_ms;
+}
+
+// Texture_Format bits the device can sample
+u32 vulkan_texture_formats() {
+    return vulkan_info.textures.formats;
 }
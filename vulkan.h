@@ -1,3 +1,5 @@
+#define VULKAN_MAX_FRAMES_IN_FLIGHT 4 // upper limit of Vulkan_Info::frames_in_flight
+
 struct Vulkan_Validation_Layers {
 	const char *data[1] = { "VK_LAYER_KHRONOS_validation" };
 	const u32 count = ARRAY_COUNT(data);
@@ -12,11 +14,13 @@ struct Vulkan_Validation_Layers {
 struct Vulkan_Queue_Family_Indices {
 	bool8 graphics_family_found;
 	bool8 present_family_found;
+	bool8 transfer_family_found; // a transfer family without graphics (dedicated copy engine)
 
 	u32 graphics_family;
 	u32 present_family;
+	u32 transfer_family;         // == graphics_family when there is no dedicated one
 
-	static const u32 unique_families = 2;
+	static const u32 max_unique_families = 3;
 };
 
 struct Vulkan_Swap_Chain_Support_Details {
@@ -33,8 +37,372 @@ struct Vulkan_Swap_Chain_Support_Details {
 struct Vulkan_Graphics_Pipeline {
 	File vert; // compiled shaders
 	File frag;
-	VkVertexInputBindingDescription binding_description;
-	VkVertexInputAttributeDescription attribute_descriptions[3];
+	VkVertexInputBindingDescription binding_descriptions[2]; // 0: Vertex, 1: per instance Matrix_4x4
+	VkVertexInputAttributeDescription attribute_descriptions[7];
+};
+
+//
+// Pipeline Cache
+//
+
+#define VULKAN_PIPELINE_CACHE_MAGIC 0x43505642 // "BVPC"
+
+// written in front of the VkPipelineCache data. the cache is only used if
+// everything matches the device it is loaded on.
+struct Vulkan_Pipeline_Cache_Header {
+	u32 magic;
+	u32 data_size;
+	u32 vendor_id;
+	u32 device_id;
+	u32 driver_version;
+	u8 pipeline_cache_uuid[VK_UUID_SIZE];
+};
+
+//
+// Memory
+//
+
+#define VULKAN_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+
+// free range inside of a block. kept sorted by offset so that neighbours can be merged.
+struct Vulkan_Memory_Range {
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	Vulkan_Memory_Range *next;
+};
+
+// one VkDeviceMemory allocation that gets carved up.
+// blocks in a buffer pool also own a VkBuffer that covers the whole block.
+struct Vulkan_Memory_Block {
+	VkDeviceMemory memory;
+	VkBuffer buffer;
+	u32 memory_type_index;
+	VkDeviceSize size;
+
+	Vulkan_Memory_Range *free_ranges;
+	Vulkan_Memory_Block *next;
+};
+
+struct Vulkan_Memory_Pool {
+	VkBufferUsageFlags buffer_usage; // 0 = image pool (no VkBuffer per block)
+	VkMemoryPropertyFlags properties;
+	VkDeviceSize block_size;
+
+	Vulkan_Memory_Block *blocks;
+	u32 blocks_count;
+};
+
+struct Vulkan_Allocation {
+	Vulkan_Memory_Block *block;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+};
+
+//
+// Staging
+//
+
+#define VULKAN_STAGING_RING_SIZE (32 * 1024 * 1024)
+
+// persistently mapped upload memory. head and tail only ever grow, (position % size) is the offset.
+// space is reclaimed when the fence of the frame that used it signals.
+struct Vulkan_Staging_Ring {
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	u8 *mapped;
+
+	VkDeviceSize size;
+	VkDeviceSize alignment;
+	VkDeviceSize head; // end of the last allocation
+	VkDeviceSize tail; // everything before tail is no longer used by the gpu
+};
+
+//
+// Uniforms
+//
+
+#define VULKAN_UNIFORM_ARENA_SIZE (4 * 1024 * 1024) // per frame in flight
+
+// persistently mapped uniform memory with one region per frame in flight.
+// every update gets its own slice and the draws bind it with a dynamic offset.
+// instanced draws also put their per instance transforms in it.
+struct Vulkan_Uniform_Arena {
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	u8 *mapped;
+
+	VkDeviceSize frame_size; // size of the region of one frame
+	VkDeviceSize alignment;  // minUniformBufferOffsetAlignment
+	VkDeviceSize head;       // in the region of the current frame
+	u32 dynamic_offset;      // slice used by draws until the next update
+};
+
+//
+// GPU Profiler
+//
+
+// timestamps are written into the frame's query pool and read back once its fence
+// signaled again, so the timings are from frames_in_flight frames ago.
+
+#define VULKAN_MAX_GPU_MARKERS 32 // per frame, includes "frame" and "render_pass"
+
+struct Vulkan_GPU_Marker {
+	const char *name;          // has to stay valid until the frame is read back
+	u32 depth;                 // nesting level
+	u32 start_query;           // end query is start_query + 1
+	bool8 ended;
+};
+
+struct Vulkan_GPU_Timing {
+	const char *name;
+	u32 depth;
+	float32 ms;
+};
+
+struct Vulkan_Profiler {
+	bool8 enabled;             // the graphics queue supports timestamps
+	float32 timestamp_period;  // nanoseconds per tick
+	u64 timestamp_mask;        // from timestampValidBits
+
+	VkQueryPool query_pools[VULKAN_MAX_FRAMES_IN_FLIGHT];
+	Vulkan_GPU_Marker markers[VULKAN_MAX_FRAMES_IN_FLIGHT][VULKAN_MAX_GPU_MARKERS];
+	u32 markers_count[VULKAN_MAX_FRAMES_IN_FLIGHT];
+
+	u32 open_markers[VULKAN_MAX_GPU_MARKERS]; // stack of the markers begun in the recording frame
+	u32 open_markers_count;
+	u32 dropped_markers_count; // begun after the frame's markers ran out
+
+	// latest frame that was read back
+	Vulkan_GPU_Timing timings[VULKAN_MAX_GPU_MARKERS];
+	u32 timings_count;
+	float32 frame_ms;          // < 0 until a frame was read back
+};
+
+//
+// Textures
+//
+
+#define VULKAN_MAX_SAMPLERS          16
+#define VULKAN_TEXTURE_SETS_PER_POOL 256
+#define VULKAN_MAX_BINDLESS_TEXTURES 4096 // lowered to the device limits
+
+// textures with the same parameters share one sampler
+struct Vulkan_Sampler_Key {
+	VkFilter mag_filter;
+	VkFilter min_filter;
+	VkSamplerMipmapMode mipmap_mode;
+	VkSamplerAddressMode address_mode;
+	bool8 anisotropy;
+	bool8 mipmaps;   // false samples only the first level
+};
+
+struct Vulkan_Sampler {
+	Vulkan_Sampler_Key key;
+	VkSampler sampler;
+};
+
+// Bitmap::gpu_handle points to one of these
+struct Vulkan_Texture {
+	VkImage image;
+	Vulkan_Allocation memory;
+	VkImageView view;
+	VkFormat format;
+	u32 width;
+	u32 height;
+	u32 mip_levels;
+
+	VkSampler sampler;                // owned by the texture table
+	VkDescriptorSet descriptor_set;   // set 1 of the pipeline layout: the image with its sampler. not used bindless
+	VkDescriptorPool descriptor_pool; // the set was allocated from
+	u32 bindless_index;               // element of the bindless array
+	u32 table_index;
+};
+
+struct Vulkan_Texture_Table {
+	Vulkan_Texture **textures;
+	u32 textures_count;
+	u32 textures_capacity;
+
+	Vulkan_Sampler samplers[VULKAN_MAX_SAMPLERS];
+	u32 samplers_count;
+
+	VkDescriptorSetLayout set_layout; // layout of set 1
+	VkDescriptorPool *pools;          // a new pool gets added when all of them are full
+	u32 pools_count;
+	u32 pools_capacity;
+
+	// bindless: set 1 is one array of every texture. draws pick theirs with a push constant.
+	VkDescriptorPool bindless_pool;
+	VkDescriptorSet bindless_set;
+	u32 bindless_capacity;            // elements in the array
+	u32 bindless_next_index;          // indices from here on were never used
+	u32 *free_indices;                // given back by deleted textures
+	u32 free_indices_count;
+	u32 free_indices_capacity;
+
+	u32 formats;                      // Texture_Format bits the device can sample
+
+	Vulkan_Texture *default_texture;  // 1x1 white, drawn with when nothing is bound
+	Vulkan_Texture *bound;            // used by the draws after vulkan_bind_bitmap()
+};
+
+//
+// Draw List
+//
+
+// draws collected by vulkan_draw_list_add() and issued by vulkan_draw_list_submit()
+struct Vulkan_Draw {
+	Vulkan_Memory_Block *block; // draws sharing a block share the vertex and index buffer
+	u32 uniform_offset;         // dynamic offset of the Matrices when the draw was added
+	u32 indices_count;
+	u32 first_index;            // in the block buffer
+	s32 vertex_offset;          // in the block buffer
+	u32 instances_count;
+	u32 first_transform;        // in transforms
+	VkDescriptorSet texture_set;
+	u32 texture_index;          // bindless
+	bool8 written;              // used while grouping
+};
+
+struct Vulkan_Draw_List {
+	Vulkan_Draw *draws;
+	u32 draws_count;
+	u32 draws_capacity;
+
+	Matrix_4x4 *transforms;     // per instance transforms of all the draws
+	u32 transforms_count;
+	u32 transforms_capacity;
+};
+
+//
+// Parallel Recording
+//
+
+#define VULKAN_MAX_RECORDING_JOBS 8
+#define VULKAN_MIN_DRAWS_PER_JOB 64
+
+// records draws [first_draw, first_draw + draws_count) of the draw list into a secondary command buffer
+struct Vulkan_Recording_Job {
+	VkCommandBuffer command_buffer;
+	u32 first_draw;
+	u32 draws_count;
+	VkDeviceSize instances_offset; // of the transforms in the uniform arena
+};
+
+// with parallel recording the draws of a frame are deferred to vulkan_end_frame() and
+// split across the work queue. every job has its own command pool for each frame.
+struct Vulkan_Recorder {
+	Work_Queue *work_queue;
+	VkCommandPool command_pools[VULKAN_MAX_FRAMES_IN_FLIGHT][VULKAN_MAX_RECORDING_JOBS];
+	VkCommandBuffer command_buffers[VULKAN_MAX_FRAMES_IN_FLIGHT][VULKAN_MAX_RECORDING_JOBS];
+	Vulkan_Recording_Job jobs[VULKAN_MAX_RECORDING_JOBS];
+};
+
+//
+// Headless
+//
+
+// render target of headless mode. the images stand in for the swap chain images
+// (one per frame in flight) and the render pass leaves them in TRANSFER_SRC_OPTIMAL.
+struct Vulkan_Headless {
+	Vulkan_Allocation images_memory[VULKAN_MAX_FRAMES_IN_FLIGHT];
+
+	VkBuffer readback_buffer;
+	VkDeviceMemory readback_memory;
+	u8 *readback_mapped;
+	VkDeviceSize readback_size;
+	bool8 readback_requested; // copy the image of the next vulkan_end_frame() to readback_buffer
+	bool8 readback_recorded;
+};
+
+//
+// Deletion Queue
+//
+
+// resources the gpu might still use get destroyed once the fence of the frame slot
+// they were queued in signaled again. every frame submitted before has finished then.
+// this lets meshes, textures and staging buffers be freed without vkDeviceWaitIdle.
+
+enum Vulkan_Deletion_Type {
+	VULKAN_DELETION_SWAP_CHAIN,
+	VULKAN_DELETION_FRAMEBUFFER,
+	VULKAN_DELETION_IMAGE_VIEW,
+	VULKAN_DELETION_IMAGE,      // image + allocation
+	VULKAN_DELETION_BUFFER,     // buffer + memory (if not VK_NULL_HANDLE)
+	VULKAN_DELETION_MEMORY,
+	VULKAN_DELETION_ALLOCATION,
+	VULKAN_DELETION_PIPELINE,
+	VULKAN_DELETION_SAMPLER,
+	VULKAN_DELETION_DESCRIPTOR_SET, // descriptor_set + descriptor_pool
+	VULKAN_DELETION_BINDLESS_INDEX, // the index can be given to a new texture
+};
+
+struct Vulkan_Deletion {
+	Vulkan_Deletion_Type type;
+	union {
+		VkSwapchainKHR swap_chain;
+		VkFramebuffer framebuffer;
+		VkImageView image_view;
+		VkImage image;
+		VkBuffer buffer;
+		VkPipeline pipeline;
+		VkSampler sampler;
+		VkDescriptorSet descriptor_set;
+		u32 bindless_index;
+	};
+	VkDeviceMemory memory;
+	VkDescriptorPool descriptor_pool;
+	Vulkan_Allocation allocation;
+};
+
+struct Vulkan_Deletion_Queue {
+	Vulkan_Deletion *deletions;
+	u32 deletions_count;
+	u32 deletions_capacity;
+};
+
+//
+// Uploads
+//
+
+#define VULKAN_UPLOAD_BATCHES 2
+
+// the transfer queue can't blit so with a dedicated one the mip chain is made on
+// the graphics queue in acquire_command_buffer, right after the ownership transfer
+struct Vulkan_Mip_Job {
+	VkImage image;
+	u32 width;
+	u32 height;
+	u32 mip_levels;
+};
+
+// copies and layout transitions get recorded into the open batch and submitted together.
+// with a dedicated transfer queue the batch releases ownership of what it wrote and
+// acquire_command_buffer acquires it on the graphics queue after waiting on semaphore.
+struct Vulkan_Upload_Batch {
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+	bool8 recording;
+	bool8 submitted; // fence has not been waited on yet
+
+	VkSemaphore semaphore;
+	VkCommandBuffer acquire_command_buffer;
+	VkFence acquire_fence;
+	bool8 acquire_pending;   // released on the transfer queue but not submitted on graphics yet
+	bool8 acquire_submitted; // acquire_fence has not been waited on yet
+
+	// acquire half of the ownership transfers. the release half is made from these.
+	VkBufferMemoryBarrier *buffer_barriers;
+	u32 buffer_barriers_count;
+	u32 buffer_barriers_capacity;
+
+	VkImageMemoryBarrier *image_barriers;
+	u32 image_barriers_count;
+	u32 image_barriers_capacity;
+
+	Vulkan_Mip_Job *mip_jobs;
+	u32 mip_jobs_count;
+	u32 mip_jobs_capacity;
 };
 
 struct Vulkan_Info {
@@ -42,10 +410,18 @@ struct Vulkan_Info {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
-	static const u32 MAX_FRAMES_IN_FLIGHT = 2;
+	u32 frames_in_flight = 2; // config: 1 to VULKAN_MAX_FRAMES_IN_FLIGHT, set before init
 	u32 current_frame;
 
-	s32 window_width;
+	// preferred mode. falls back to FIFO (always supported) if the surface does not have it.
+	VkPresentModeKHR present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR; // config: applied when the swap chain is (re)created
+	VkPresentModeKHR active_present_mode;
+	bool8 low_latency = false; // config: wait for the frame's fence before input is sampled
+
+	bool8 headless = false; // config: render offscreen without a surface or swap chain
+	Vulkan_Headless headless_target;
+
+	s32 window_width;       // size of the offscreen images in headless mode
 	s32 window_height;
 	bool8 framebuffer_resized = false;
 	bool8 minimized;
@@ -67,10 +443,24 @@ struct Vulkan_Info {
 	VkPipelineLayout pipeline_layout;
 	VkPipeline graphics_pipeline;
 
+	const char *pipeline_cache_filepath = "pipeline_cache.bin"; // config: set before init
+	VkPipelineCache pipeline_cache;
+
+	const char *shader_cache_path = "shader_cache"; // directory of compiled SPIR-V. config: set before init
+
+	bool8 sampler_anisotropy;      // feature is supported and enabled
+	bool8 texture_compression_bc;  // feature is supported and enabled
+	bool8 bindless = true;         // config: textures in one descriptor array if the device has descriptor indexing. false after init if not
+
+	Vulkan_Queue_Family_Indices queue_families;
+	bool8 dedicated_transfer;      // uploads go through transfer_queue with ownership transfers
+
 	VkQueue graphics_queue;
 	VkQueue present_queue;
+	VkQueue transfer_queue;        // == graphics_queue without a dedicated transfer family
 
 	VkCommandPool command_pool;
+	VkCommandPool transfer_command_pool; // only created with a dedicated transfer family
 	Arr<VkCommandBuffer> command_buffers;
 	VkCommandBuffer command_buffer;             // set at the start of the frame for the current frame
 
@@ -86,30 +476,53 @@ struct Vulkan_Info {
 	// sync
 	Arr<VkSemaphore> image_available_semaphore;
 	Arr<VkSemaphore> render_finished_semaphore;
-	VkFence in_flight_fence[MAX_FRAMES_IN_FLIGHT];
+	VkFence in_flight_fence[VULKAN_MAX_FRAMES_IN_FLIGHT];
+	Vulkan_Deletion_Queue deletion_queues[VULKAN_MAX_FRAMES_IN_FLIGHT];
+	Vulkan_Deletion_Queue deletion_queue_pending; // queued between frames, waits for the next frame
+	bool8 frame_recording;                        // between vulkan_start_frame() and the submit
+	bool8 frame_skipped;                          // no swap chain image to draw to, nothing gets recorded until vulkan_end_frame()
+
+	// Memory
+	Vulkan_Memory_Pool buffer_pool; // device local vertex/index memory
+	Vulkan_Memory_Pool image_pool;
 
-	// Buffers	
-    VkBuffer combined_buffer;
-    VkDeviceMemory combined_buffer_memory;
-    u32 combined_buffer_offset; // where to enter new bytes
+	// Uploads
+	bool8 upload_immediate = false; // submit and wait after every upload command (the old behaviour)
+	Vulkan_Upload_Batch upload_batches[VULKAN_UPLOAD_BATCHES];
+	u32 upload_batch_index;
 
-	VkDeviceSize uniforms_offset[MAX_FRAMES_IN_FLIGHT];
+	// Staging
+	VkDeviceSize staging_ring_size = VULKAN_STAGING_RING_SIZE; // config: set before init
+	Vulkan_Staging_Ring staging_ring;
+	VkDeviceSize staging_frame_heads[VULKAN_MAX_FRAMES_IN_FLIGHT]; // staging_ring.head when the frame was submitted
+
+	// Uniforms
+	VkDeviceSize uniform_arena_size = VULKAN_UNIFORM_ARENA_SIZE; // config: set before init
+	Vulkan_Uniform_Arena uniform_arena;
 	u32 uniform_size;
+	Vulkan_Allocation identity_instance; // per instance data of non instanced draws
+
+	// Draw List
+	bool8 multi_draw_indirect; // multiDrawIndirect and drawIndirectFirstInstance are enabled
+	Vulkan_Draw_List draw_list;
+
+	Vulkan_Profiler profiler;
 
-	// Descriptors used for uniforms in shaders
+	// Parallel Recording
+	bool8 parallel_recording = false; // config: set before init
+	Vulkan_Recorder recorder;
+
+	// Descriptors used for uniforms in shaders (set 0)
 	VkDescriptorPool descriptor_pool;
 	Arr<VkDescriptorSet> descriptor_sets;
 
 	// Images
-	VkImage texture_image;
-	const VkFormat texture_image_format = VK_FORMAT_R8G8B8A8_SRGB;
-	VkDeviceMemory texture_image_memory;
-	VkImageView texture_image_view;
-	VkSampler texture_sampler;
+	Vulkan_Texture_Table textures;
 
 	VkImage depth_image;
-	VkDeviceMemory depth_image_memory;
+	Vulkan_Allocation depth_image_memory;
 	VkImageView depth_image_view;
+	VkExtent2D depth_extent; // kept when the swap chain gets smaller
 
 	// Presentation
 	VkCommandBufferBeginInfo begin_info;
@@ -126,9 +539,8 @@ struct Vulkan_Info {
 global Vulkan_Info vulkan_info;
 
 struct Vulkan_Mesh {
+    Vulkan_Allocation allocation; // vertices followed by indices
+    
     u32 vertices_offset;
     u32 indices_offset;
-    
-    u32 uniform_offsets[vulkan_info.MAX_FRAMES_IN_FLIGHT];
-    u32 uniform_size; // size of the individual uniforms
 };
@@ -0,0 +1,149 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+//
+// Work Queue
+//
+
+// one thread adds entries, the worker threads (and the adding thread in
+// work_queue_complete_all()) take them. thread_index is unique for every
+// thread working on the queue: 0 to threads_count - 1 for the workers and
+// threads_count for the thread that adds.
+
+typedef void Work_Queue_Callback(u32 thread_index, void *data);
+
+#define WORK_QUEUE_ENTRIES     256
+#define WORK_QUEUE_MAX_THREADS 16
+
+struct Work_Queue_Entry {
+	Work_Queue_Callback *callback;
+	void *data;
+};
+
+struct Work_Queue;
+
+struct Work_Queue_Thread {
+	Work_Queue *queue;
+	u32 index;
+};
+
+struct Work_Queue {
+	SDL_atomic_t completion_goal;
+	SDL_atomic_t completion_count;
+
+	SDL_atomic_t next_entry_to_write;
+	SDL_atomic_t next_entry_to_read;
+	SDL_sem *semaphore;
+
+	Work_Queue_Entry entries[WORK_QUEUE_ENTRIES];
+
+	SDL_atomic_t quit;
+	u32 threads_count;
+	SDL_Thread *threads[WORK_QUEUE_MAX_THREADS];
+	Work_Queue_Thread thread_infos[WORK_QUEUE_MAX_THREADS];
+};
+
+internal void
+work_queue_add(Work_Queue *queue, Work_Queue_Callback *callback, void *data) {
+	u32 write = (u32)SDL_AtomicGet(&queue->next_entry_to_write);
+	u32 next_write = (write + 1) % WORK_QUEUE_ENTRIES;
+	if (next_write == (u32)SDL_AtomicGet(&queue->next_entry_to_read)) {
+		logprint("work_queue_add()", "queue is full\n");
+		callback(queue->threads_count, data); // do it here instead
+		return;
+	}
+
+	Work_Queue_Entry *entry = &queue->entries[write];
+	entry->callback = callback;
+	entry->data = data;
+
+	SDL_AtomicAdd(&queue->completion_goal, 1);
+	SDL_MemoryBarrierRelease(); // entry has to be written before it is visible
+	SDL_AtomicSet(&queue->next_entry_to_write, next_write);
+	SDL_SemPost(queue->semaphore);
+}
+
+// returns true if there was nothing to do
+internal bool8
+work_queue_do_next_entry(Work_Queue *queue, u32 thread_index) {
+	u32 read = (u32)SDL_AtomicGet(&queue->next_entry_to_read);
+	if (read == (u32)SDL_AtomicGet(&queue->next_entry_to_write))
+		return true;
+
+	// copied before the entry is claimed. once next_entry_to_read moves on, work_queue_add()
+	// can reuse the slot. the copy is only used if this thread got the entry.
+	SDL_MemoryBarrierAcquire();
+	Work_Queue_Entry entry = queue->entries[read];
+
+	u32 next_read = (read + 1) % WORK_QUEUE_ENTRIES;
+	if (SDL_AtomicCAS(&queue->next_entry_to_read, read, next_read)) {
+		entry.callback(thread_index, entry.data);
+		SDL_AtomicIncRef(&queue->completion_count);
+	}
+	return false;
+}
+
+// the calling thread helps until every added entry is done
+internal void
+work_queue_complete_all(Work_Queue *queue) {
+	while (SDL_AtomicGet(&queue->completion_goal) != SDL_AtomicGet(&queue->completion_count)) {
+		work_queue_do_next_entry(queue, queue->threads_count);
+	}
+
+	SDL_AtomicSet(&queue->completion_goal, 0);
+	SDL_AtomicSet(&queue->completion_count, 0);
+}
+
+internal int
+work_queue_thread_proc(void *data) {
+	Work_Queue_Thread *thread = (Work_Queue_Thread*)data;
+	Work_Queue *queue = thread->queue;
+
+	while (1) {
+		if (work_queue_do_next_entry(queue, thread->index)) {
+			if (SDL_AtomicGet(&queue->quit))
+				break;
+			SDL_SemWait(queue->semaphore);
+		}
+	}
+
+	return 0;
+}
+
+internal void
+work_queue_init(Work_Queue *queue, u32 threads_count) {
+	*queue = {};
+	if (threads_count > WORK_QUEUE_MAX_THREADS)
+		threads_count = WORK_QUEUE_MAX_THREADS;
+
+	queue->semaphore = SDL_CreateSemaphore(0);
+	queue->threads_count = threads_count;
+
+	for (u32 i = 0; i < threads_count; i++) {
+		queue->thread_infos[i].queue = queue;
+		queue->thread_infos[i].index = i;
+		queue->threads[i] = SDL_CreateThread(work_queue_thread_proc, "work_queue", &queue->thread_infos[i]);
+		if (queue->threads[i] == NULL) {
+			logprint("work_queue_init()", "failed to create thread\n");
+		}
+	}
+}
+
+// finishes the queued entries and stops the threads
+internal void
+work_queue_destroy(Work_Queue *queue) {
+	work_queue_complete_all(queue);
+
+	SDL_AtomicSet(&queue->quit, 1);
+	for (u32 i = 0; i < queue->threads_count; i++)
+		SDL_SemPost(queue->semaphore);
+	for (u32 i = 0; i < queue->threads_count; i++) {
+		if (queue->threads[i] != NULL)
+			SDL_WaitThread(queue->threads[i], NULL);
+	}
+
+	SDL_DestroySemaphore(queue->semaphore);
+	queue->semaphore = 0;
+}
+
+#endif // WORK_QUEUE_H